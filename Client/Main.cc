@@ -1,8 +1,10 @@
 #include <Client/Game.hh>
 #include <Client/Setup.hh>
 
+#include <ctime>
+
 int main() {
-    srand(std::time(0));
+    seed_frand(std::time(0));
     Game::init();
     main_loop();
     return 0;
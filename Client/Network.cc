@@ -28,19 +28,23 @@ void Game::on_message(uint8_t *ptr, uint32_t len) {
                 assert(simulation.ent_exists(curr_id));
                 Entity &ent = simulation.get_ent(curr_id);
                 ent.read(&reader, BitMath::at(create, 0));
+                if (BitMath::at(create, 0)) simulation.sync_components(ent);
                 if (BitMath::at(create, 1)) ent.pending_delete = 1;
                 curr_id = reader.read<EntityID>();
             }
             simulation.arena_info.read(&reader, reader.read<uint8_t>());
             break;
         }
+        case Clientbound::kServerInfo:
+            simulation.set_capacity(reader.read<uint32_t>());
+            break;
         default:
             break;
     }
 }
 
 void Game::send_inputs() {
-    Writer writer(static_cast<uint8_t *>(OUTGOING_PACKET));
+    Writer writer(static_cast<uint8_t *>(OUTGOING_PACKET), sizeof(OUTGOING_PACKET));
     writer.write<uint8_t>(Serverbound::kClientInput);
     if (Input::freeze_input) {
         writer.write<float>(0);
@@ -55,7 +59,7 @@ void Game::send_inputs() {
 }
 
 void Game::spawn_in() {
-    Writer writer(static_cast<uint8_t *>(OUTGOING_PACKET));
+    Writer writer(static_cast<uint8_t *>(OUTGOING_PACKET), sizeof(OUTGOING_PACKET));
     if (Game::alive()) return;
     if (Game::on_game_screen == 0) {
         writer.write<uint8_t>(Serverbound::kClientSpawn);
@@ -66,7 +70,7 @@ void Game::spawn_in() {
 }
 
 void Game::delete_petal(uint8_t pos) {
-    Writer writer(static_cast<uint8_t *>(OUTGOING_PACKET));
+    Writer writer(static_cast<uint8_t *>(OUTGOING_PACKET), sizeof(OUTGOING_PACKET));
     if (!Game::alive()) return;
     writer.write<uint8_t>(Serverbound::kPetalDelete);
     writer.write<uint8_t>(pos);
@@ -74,7 +78,7 @@ void Game::delete_petal(uint8_t pos) {
 }
 
 void Game::swap_petals(uint8_t pos1, uint8_t pos2) {
-    Writer writer(static_cast<uint8_t *>(OUTGOING_PACKET));
+    Writer writer(static_cast<uint8_t *>(OUTGOING_PACKET), sizeof(OUTGOING_PACKET));
     if (!Game::alive()) return;
     writer.write<uint8_t>(Serverbound::kPetalSwap);
     writer.write<uint8_t>(pos1);
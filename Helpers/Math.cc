@@ -1,5 +1,6 @@
 #include <Helpers/Math.hh>
 
+#include <atomic>
 #include <cmath>
 #include <format>
 
@@ -9,8 +10,58 @@ float fclamp(float v, float s, float e) {
     return v;
 }
 
+//seed_frand bumps the generation, and every thread restarts its stream
+//from the new seed the next time it sees a generation it has not seeded from
+static std::atomic<uint64_t> frand_seed(0);
+static std::atomic<uint32_t> frand_generation(0);
+
+struct FrandState {
+    Rng rng = Rng(0);
+    uint64_t stream = 0;
+    uint32_t generation = 0;
+};
+
+static thread_local FrandState frand_state;
+
+//splitmix64 finalizer, so nearby stream numbers start far apart
+static uint64_t _mix(uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+static void _start_stream(uint64_t stream) {
+    frand_state.stream = stream;
+    frand_state.generation = frand_generation.load(std::memory_order_acquire);
+    uint64_t seed = frand_seed.load(std::memory_order_relaxed);
+    frand_state.rng.seed(stream == 0 ? seed : seed ^ _mix(stream), stream);
+}
+
 double frand() {
-    return std::rand() / (double) RAND_MAX;
+    if (frand_state.generation != frand_generation.load(std::memory_order_acquire))
+        _start_stream(frand_state.stream);
+    return frand_state.rng.frand();
+}
+
+void seed_frand(uint64_t seed) {
+    frand_seed.store(seed, std::memory_order_relaxed);
+    frand_generation.fetch_add(1, std::memory_order_release);
+    _start_stream(frand_state.stream);
+}
+
+void select_frand_stream(uint64_t stream) {
+    _start_stream(stream);
+}
+
+FrandStream::FrandStream(uint64_t stream) : saved_rng(frand_state.rng),
+    saved_stream(frand_state.stream), saved_generation(frand_state.generation) {
+    _start_stream(stream);
+}
+
+FrandStream::~FrandStream() {
+    frand_state.rng = saved_rng;
+    frand_state.stream = saved_stream;
+    frand_state.generation = saved_generation;
 }
 
 float lerp(float v, float e, float a) {
@@ -92,6 +143,35 @@ float SeedGenerator::binext() {
     return next() * 2 - 1;
 }
 
+//the increment (always odd) picks one of 2^63 streams, each a different sequence
+static uint64_t const PCG_MULTIPLIER = 6364136223846793005ull;
+static uint64_t const PCG_INCREMENT = 1442695040888963407ull;
+
+Rng::Rng(uint64_t s, uint64_t stream) {
+    seed(s, stream);
+}
+
+//stream 0 keeps the original fixed increment
+void Rng::seed(uint64_t s, uint64_t stream) {
+    increment = stream == 0 ? PCG_INCREMENT : (stream << 1) | 1;
+    state = 0;
+    next();
+    state += s;
+    next();
+}
+
+uint32_t Rng::next() {
+    uint64_t old = state;
+    state = old * PCG_MULTIPLIER + increment;
+    uint32_t xorshifted = ((old >> 18) ^ old) >> 27;
+    uint32_t rot = old >> 59;
+    return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+}
+
+double Rng::frand() {
+    return next() * (1.0 / 4294967296.0);
+}
+
 RangeValue::RangeValue(float l, float u) : lower(l), upper(u) {}
 
 RangeValue::RangeValue(float l) : lower(l), upper(l) {}
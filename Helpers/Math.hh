@@ -9,7 +9,13 @@ constexpr double M_PI = 3.14159265358979323846;
 
 constexpr uint32_t div_round_up(uint32_t a, uint32_t b) { return (a + b - 1) / b; }
 
+//uniform in [0, 1), drawn from the calling thread's frand stream
 double frand();
+//restarts every thread's frand stream from this seed (threads pick it up on their next frand())
+void seed_frand(uint64_t);
+//switches the calling thread to another stream of the frand seed, started from its beginning
+//streams are independent, so threads that each draw from their own do not share numbers
+void select_frand_stream(uint64_t);
 float fclamp(float, float, float);
 float lerp(float, float, float);
 float angle_lerp(float, float, float);
@@ -37,6 +43,31 @@ public:
     float binext();
 };
 
+//pcg32: no locking, reproducible from its seed and stream
+class Rng {
+    uint64_t state;
+    uint64_t increment;
+public:
+    Rng(uint64_t, uint64_t = 0);
+    void seed(uint64_t, uint64_t = 0);
+    uint32_t next();
+    double frand();
+};
+
+//while alive, frand() on the constructing thread draws from the given stream instead of its own
+//keying the stream on the work rather than the thread makes the numbers independent of which
+//thread does the work. the thread's own stream carries on where it was once this is destroyed
+class FrandStream {
+    Rng saved_rng;
+    uint64_t saved_stream;
+    uint32_t saved_generation;
+public:
+    FrandStream(uint64_t);
+    ~FrandStream();
+    FrandStream(FrandStream const &) = delete;
+    FrandStream &operator=(FrandStream const &) = delete;
+};
+
 class RangeValue {
 public:
     float lower;
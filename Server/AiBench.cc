@@ -0,0 +1,126 @@
+#include <Server/EntityFunctions.hh>
+#include <Server/Scheduler.hh>
+#include <Server/Spawn.hh>
+
+#include <Shared/Map.hh>
+#include <Shared/Simulation.hh>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+//times mob target acquisition (gardn-ai-bench target)
+//usage: gardn-ai-bench [mob spawns] [players] [threads, 0 for one per core] [rounds]
+//mobs are spawned over the whole arena by zone (groups and centipedes add more than one),
+//players are scattered among them, each with a summoned soldier ant. every round, every mob
+//whose search is due looks for a target, once the way find_nearest_enemy used to (a
+//SpatialHash::nearest search with the rules as a predicate) and once through the
+//TargetIndex and acquire_targets. exits with 1 if they disagree
+
+typedef std::chrono::duration<double, std::milli> ms_t;
+
+//the search find_nearest_enemy made before TargetIndex
+static EntityID _reference_search(Simulation *simulation, Entity const &entity, float radius) {
+    return simulation->spatial_hash.nearest(entity.get_x(), entity.get_y(), radius, [&](Entity &ent) {
+        if (!simulation->ent_alive(ent.id)) return false;
+        if (ent.get_team() == entity.get_team()) return false;
+        if (ent.immunity_ticks > 0) return false;
+        if (!ent.has_component(kMob) && !ent.has_component(kFlower)) return false;
+        if (simulation->ent_alive(entity.get_parent())) {
+            Entity &parent = simulation->get_ent(entity.get_parent());
+            float dist = Vector(ent.get_x()-parent.get_x(),ent.get_y()-parent.get_y()).magnitude();
+            if (dist > SUMMON_RETREAT_RADIUS) return false;
+        }
+        return true;
+    });
+}
+
+int main(int argc, char **argv) {
+    uint32_t mob_spawns = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4000;
+    uint32_t players = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 100;
+    uint32_t threads = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 0;
+    uint32_t rounds = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 10 * (TPS / 5);
+    Scheduler::init(threads);
+    seed_frand(0);
+    Simulation *sim = new Simulation();
+    sim->set_capacity(4 * mob_spawns + 4 * players + 64);
+    for (uint32_t i = 0; i < mob_spawns; ++i) {
+        float x = frand() * ARENA_WIDTH, y = frand() * ARENA_HEIGHT;
+        alloc_mob(sim, Map::random_zone_mob(Map::get_zone_from_pos(x, y)), x, y, NULL_ENTITY);
+    }
+    for (uint32_t i = 0; i < players; ++i) {
+        //a camera per player for the team, like GameInstance::add_client
+        Entity &camera = sim->alloc_ent();
+        sim->add_component(camera, kCamera);
+        sim->add_component(camera, kRelations);
+        camera.set_team(camera.id);
+        Entity &player = alloc_player(sim, camera.id);
+        player.set_x(frand() * ARENA_WIDTH);
+        player.set_y(frand() * ARENA_HEIGHT);
+        Entity &summon = alloc_mob(sim, MobID::kSoldierAnt, player.get_x() + 100, player.get_y(), camera.id);
+        summon.set_parent(player.id);
+    }
+    //one tick so every entity counts as alive at the start of a tick
+    sim->tick();
+    sim->post_tick();
+    std::vector<Entity *> mobs;
+    uint32_t flowers = 0;
+    sim->for_each_entity([&](Simulation *, Entity &ent) {
+        ent.immunity_ticks = 0;
+        if (ent.has_component(kFlower)) ++flowers;
+    });
+    //the mobs acquire_targets visits: a mob spawned during that tick does not count until the next
+    sim->for_each<kMob>([&](Simulation *, Entity &ent) {
+        //as if every mob were in view of a player
+        BitMath::unset(ent.flags, EntityFlags::kIsCulled);
+        mobs.push_back(&ent);
+    });
+
+    ms_t reference_time(0), batched_time(0);
+    uint64_t searches = 0, found = 0, mismatches = 0;
+    std::vector<EntityID> expected(sim->capacity());
+    sim->spatial_hash.refresh(ARENA_WIDTH, ARENA_HEIGHT);
+    for (uint32_t round = 0; round < rounds; ++round) {
+        //every mob idle and looking, with the searches staggered across rounds as in ticks
+        for (Entity *ent : mobs) {
+            ++ent->lifetime;
+            ent->target = NULL_ENTITY;
+            ent->last_damaged_by = NULL_ENTITY;
+        }
+        sim->spatial_hash.begin_tick();
+        sim->for_each_entity([](Simulation *sim, Entity &ent) {
+            if (ent.has_component(kPhysics)) sim->spatial_hash.insert(ent);
+        });
+        sim->spatial_hash.build();
+        auto start = std::chrono::steady_clock::now();
+        for (Entity *ent : mobs) {
+            if ((ent->id.id - ent->lifetime) % (TPS / 5) != 0) continue;
+            expected[ent->id.id] = _reference_search(sim, *ent, ent->detection_radius + ent->get_radius());
+        }
+        auto searched = std::chrono::steady_clock::now();
+        sim->target_index.begin_tick();
+        sim->for_each_entity([](Simulation *sim, Entity &ent) {
+            if (ent.has_component(kMob) || ent.has_component(kFlower)) sim->target_index.insert(ent);
+        });
+        sim->target_index.build();
+        acquire_targets(sim);
+        for (Entity *ent : mobs) {
+            if ((ent->id.id - ent->lifetime) % (TPS / 5) != 0) continue;
+            EntityID target = find_nearest_enemy(sim, *ent, ent->detection_radius + ent->get_radius());
+            ++searches;
+            if (!(target == NULL_ENTITY)) ++found;
+            if (!(target == expected[ent->id.id])) ++mismatches;
+        }
+        auto batched = std::chrono::steady_clock::now();
+        reference_time += searched - start;
+        batched_time += batched - searched;
+    }
+    std::cout << "Threads: " << Scheduler::thread_count() << '\n';
+    std::cout << "Mobs: " << mobs.size() << ", flowers: " << flowers << '\n';
+    std::cout << "Searches/round: " << (double) searches / rounds << ", found: " << (double) found / rounds << '\n';
+    std::cout << "Mismatches: " << mismatches << '\n';
+    std::cout << "ms/round SpatialHash::nearest: " << reference_time.count() / rounds << '\n';
+    std::cout << "ms/round TargetIndex + acquire_targets: " << batched_time.count() / rounds << '\n';
+    return mismatches > 0;
+}
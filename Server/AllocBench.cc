@@ -0,0 +1,43 @@
+#include <Shared/Simulation.hh>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+//times the entity allocator (gardn-alloc-bench target)
+//usage: gardn-alloc-bench [entity capacity] [operations]
+//the table is filled to 10%, 50% and 99% of capacity, then each operation deletes a
+//random live entity and allocates one, so occupancy stays put while the slots churn
+
+typedef std::chrono::duration<double, std::nano> ns_t;
+
+static double _churn(Simulation *sim, double occupancy, uint32_t operations) {
+    sim->reset();
+    Rng rng(0);
+    std::vector<EntityID> live;
+    //slot 0 is NULL_ENTITY
+    uint32_t const count = (sim->capacity() - 1) * occupancy;
+    for (uint32_t i = 0; i < count; ++i)
+        live.push_back(sim->alloc_ent().id);
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < operations; ++i) {
+        EntityID &victim = live[rng.next() % live.size()];
+        sim->_delete_ent(victim);
+        victim = sim->alloc_ent().id;
+    }
+    ns_t elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / operations;
+}
+
+int main(int argc, char **argv) {
+    uint32_t entity_cap = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : DEFAULT_ENTITY_CAP;
+    uint32_t operations = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000000;
+    Simulation *sim = new Simulation();
+    sim->set_capacity(entity_cap);
+    std::cout << "Entity Capacity: " << sim->capacity() << '\n';
+    std::cout << "Operations: " << operations << '\n';
+    for (double occupancy : {0.1, 0.5, 0.99})
+        std::cout << "occupancy " << occupancy * 100 << "%: " << _churn(sim, occupancy, operations) << " ns/delete+alloc\n";
+    return 0;
+}
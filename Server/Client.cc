@@ -20,6 +20,11 @@ Client::Client() : game(nullptr) {}
 void Client::init() {
     DEBUG_ONLY(assert(game == nullptr);)
     Server::game.add_client(this);    
+    //the client sizes its simulation to fit every EntityID it may be sent
+    Writer writer(Server::OUTGOING_PACKET, MAX_PACKET_LEN);
+    writer.write<uint8_t>(Clientbound::kServerInfo);
+    writer.write<uint32_t>(game->simulation.capacity());
+    send_packet(writer.packet, writer.at - writer.packet);
 }
 
 void Client::remove() {
@@ -124,10 +129,11 @@ void Client::on_message(WebSocket *ws, std::string_view message, uint64_t code)
                 uint8_t rarity = PETAL_DATA[old_id].rarity;
                 player.set_score(player.get_score() + RARITY_TO_XP[rarity]);
                 //need to delete if over cap
-                if (player.deleted_petals.size() == player.deleted_petals.capacity())
+                circ_arr_t &deleted_petals = simulation->get_flower_data(player).deleted_petals;
+                if (deleted_petals.size() == deleted_petals.capacity())
                     //removes old trashed old petal
-                    PetalTracker::remove_petal(simulation, player.deleted_petals[0]);
-                player.deleted_petals.push_back(old_id);
+                    PetalTracker::remove_petal(simulation, deleted_petals[0]);
+                deleted_petals.push_back(old_id);
             }
             player.set_loadout_ids(pos, PetalID::kNone);
             break;
@@ -4,8 +4,8 @@
 #include <Shared/EntityDef.hh>
 
 #include <cstdint>
-#include <set>
 #include <string>
+#include <vector>
 
 #ifdef WASM_SERVER
 class WebSocket;
@@ -21,7 +21,9 @@ class Client {
 public:
     GameInstance *game;
     EntityID camera;
-    std::set<EntityID> in_view;
+    //bit per slot in the last update sent, and the hash each slot had then
+    std::vector<uint64_t> in_view;
+    std::vector<EntityID::hash_type> in_view_hash;
     WebSocket *ws;
     uint8_t verified = 0;
     uint8_t seen_arena = 0;
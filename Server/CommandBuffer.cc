@@ -0,0 +1,69 @@
+#include <Server/CommandBuffer.hh>
+
+Command &CommandBuffer::_push(uint8_t kind, EntityID const &issuer) {
+    Command &command = commands.emplace_back();
+    command.kind = kind;
+    command.phase = phase;
+    command.seq = next_seq++;
+    command.issuer = issuer.id;
+    return command;
+}
+
+void CommandBuffer::spawn_mob(EntityID const &issuer, MobID::T mob_id, float x, float y,
+    EntityID const &team, EntityID const &parent, EntityID const &target, game_tick_t despawn_ticks) {
+    Command &command = _push(Command::kSpawnMob, issuer);
+    command.mob_id = mob_id;
+    command.x = x;
+    command.y = y;
+    command.team = team;
+    command.subject = parent;
+    command.other = target;
+    command.despawn_ticks = despawn_ticks;
+}
+
+void CommandBuffer::spawn_web(EntityID const &issuer, EntityID const &owner, float radius) {
+    Command &command = _push(Command::kSpawnWeb, issuer);
+    command.subject = owner;
+    command.radius = radius;
+}
+
+void CommandBuffer::spawn_missile(EntityID const &issuer, EntityID const &owner, float angle) {
+    Command &command = _push(Command::kSpawnMissile, issuer);
+    command.subject = owner;
+    command.angle = angle;
+}
+
+void CommandBuffer::request_delete(EntityID const &issuer, EntityID const &id) {
+    _push(Command::kDelete, issuer).subject = id;
+}
+
+void CommandBuffer::inflict_damage(EntityID const &issuer, EntityID const &atk_id, EntityID const &def_id, float amt, uint8_t type) {
+    Command &command = _push(Command::kDamage, issuer);
+    command.subject = def_id;
+    command.other = atk_id;
+    command.amount = amt;
+    command.damage_type = type;
+}
+
+void CommandBuffer::inflict_heal(EntityID const &issuer, EntityID const &id, float amt) {
+    Command &command = _push(Command::kHeal, issuer);
+    command.subject = id;
+    command.amount = amt;
+}
+
+void CommandBuffer::set_target(EntityID const &issuer, EntityID const &id, EntityID const &target) {
+    Command &command = _push(Command::kSetTarget, issuer);
+    command.subject = id;
+    command.other = target;
+}
+
+void CommandBuffer::pickup_drop(EntityID const &issuer, EntityID const &player, EntityID const &drop) {
+    Command &command = _push(Command::kPickupDrop, issuer);
+    command.subject = player;
+    command.other = drop;
+}
+
+void CommandBuffer::clear() {
+    commands.clear();
+    next_seq = 0;
+}
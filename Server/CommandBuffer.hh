@@ -0,0 +1,67 @@
+#pragma once
+
+#include <Shared/Entity.hh>
+
+#include <vector>
+
+//world changes recorded by a system instead of being applied mid-iteration
+//every command names the entity whose system issued it, and Simulation::flush_commands
+//applies them ordered by (phase, issuer, order issued), so the result does not
+//depend on which thread recorded what
+struct Command {
+    enum Kind : uint8_t {
+        kSpawnMob,
+        kSpawnWeb,
+        kSpawnMissile,
+        kDelete,
+        kDamage,
+        kHeal,
+        kSetTarget,
+        kPickupDrop
+    };
+    uint8_t kind;
+    uint8_t damage_type;
+    MobID::T mob_id;
+    uint32_t phase;
+    uint32_t seq;
+    EntityID::id_type issuer;
+    //spawned mob's parent, the web or missile's owner, or the entity acted on
+    EntityID subject;
+    //spawned mob's target, attacker, new target or picked up drop
+    EntityID other;
+    EntityID team;
+    float x;
+    float y;
+    float radius;
+    float angle;
+    float amount;
+    //spawned mob despawns after this many ticks, 0 for never
+    game_tick_t despawn_ticks;
+};
+
+//one per Scheduler thread, see Simulation::commands()
+class CommandBuffer {
+    uint32_t next_seq = 0;
+    Command &_push(uint8_t, EntityID const &);
+public:
+    //copied into every command, set by Simulation
+    uint32_t phase = 0;
+    std::vector<Command> commands;
+    //issuer, mob, x, y, team, parent, target, despawn ticks
+    void spawn_mob(EntityID const &, MobID::T, float, float, EntityID const &, EntityID const &, EntityID const &, game_tick_t = 0);
+    //issuer, owner, radius
+    void spawn_web(EntityID const &, EntityID const &, float);
+    //issuer, owner, angle
+    void spawn_missile(EntityID const &, EntityID const &, float);
+    //issuer, entity
+    void request_delete(EntityID const &, EntityID const &);
+    //issuer, attacker, defender, amount, DamageType
+    void inflict_damage(EntityID const &, EntityID const &, EntityID const &, float, uint8_t);
+    //issuer, entity, amount
+    void inflict_heal(EntityID const &, EntityID const &, float);
+    //issuer, entity, target
+    void set_target(EntityID const &, EntityID const &, EntityID const &);
+    //issuer, player, drop
+    void pickup_drop(EntityID const &, EntityID const &, EntityID const &);
+    void clear();
+};
@@ -0,0 +1,26 @@
+#include <Server/EncodeCache.hh>
+
+#include <Shared/Entity.hh>
+
+EncodeCache::EncodeCache() : used(0), stamp(0) {}
+
+void EncodeCache::begin_tick(uint32_t capacity) {
+    used = 0;
+    //stamp 0 is never current, so fresh and resized slots start out empty
+    if (++stamp == 0) {
+        spans.assign(spans.size(), {});
+        stamp = 1;
+    }
+    spans.resize(capacity);
+}
+
+void EncodeCache::write(Writer *writer, Entity &ent, uint8_t create) {
+    Span &span = spans[ent.id.id][create];
+    if (span.stamp != stamp) {
+        Writer encoder(bytes, used);
+        ent.write(&encoder, create);
+        span = { stamp, used, encoder.size() };
+        used += span.length;
+    }
+    writer->push(bytes.data() + span.offset, span.length);
+}
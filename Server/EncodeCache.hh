@@ -0,0 +1,33 @@
+#pragma once
+
+#include <Shared/Binary.hh>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+class Entity;
+
+//every client that sees an entity is sent the same delta (or create) bytes, so each
+//is encoded once per tick per cache, by the first client update using the cache that
+//needs it, and copied from then on. GameInstance keeps one cache per Scheduler thread
+class EncodeCache {
+    struct Span {
+        uint32_t stamp;
+        uint32_t offset;
+        uint32_t length;
+    };
+    //encoded payloads back to back. only [0, used) is meaningful, and encoding
+    //grows it when needed
+    std::vector<uint8_t> bytes;
+    uint32_t used;
+    //per slot, the delta and create payloads. only valid while their stamp is current
+    std::vector<std::array<Span, 2>> spans;
+    uint32_t stamp;
+public:
+    EncodeCache();
+    //forgets last tick's payloads. call once per tick, before the client updates
+    void begin_tick(uint32_t);
+    //writes exactly what ent.write(writer, create) would
+    void write(Writer *, Entity &, uint8_t);
+};
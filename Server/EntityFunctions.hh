@@ -12,6 +12,8 @@ void inflict_heal(Simulation *, Entity &, float);
 void entity_on_death(Simulation *, Entity const &);
 
 EntityID find_nearest_enemy(Simulation *, Entity const &, float);
+//runs the target searches find_nearest_enemy will make this tick ahead of time, in parallel
+void acquire_targets(Simulation *);
 
 void entity_set_despawn_tick(Entity &, game_tick_t);
 void entity_clear_references(Simulation *, Entity &);
@@ -1,15 +1,15 @@
 #include <Server/EntityFunctions.hh>
 
-#include <Server/Spawn.hh>
 #include <Shared/Entity.hh>
 #include <Shared/Simulation.hh>
 
 #include <cmath>
 
 static bool _yggdrasil_revival_clause(Simulation *sim, Entity &player) {
+    FlowerData const &flower = sim->get_flower_data(player);
     for (uint32_t i = 0; i < player.get_loadout_count(); ++i) {
-        if (!player.loadout[i].already_spawned) continue;
-        if (player.loadout[i].get_petal_id() != PetalID::kYggdrasil) continue;
+        if (!flower.loadout[i].already_spawned) continue;
+        if (flower.loadout[i].get_petal_id() != PetalID::kYggdrasil) continue;
         player.set_loadout_ids(i, PetalID::kNone);
         return true;
     }
@@ -40,11 +40,10 @@ void inflict_damage(Simulation *sim, EntityID const atk_id, EntityID const def_i
         uint32_t end = ceilf((defender.max_health - defender.health) / defender.max_health * num_waves);
         if (defender.health <= 0) end = num_waves + 1;
         for (uint32_t i = start; i < end; ++i) {
-            for (MobID::T mob_id : ANTHOLE_SPAWNS[i]) {
-                Entity &child = alloc_mob(sim, mob_id, defender.get_x(), defender.get_y(), defender.get_team());
-                child.set_parent(defender.id);
-                child.target = defender.target;
-            }
+            //spawned at the next flush_commands, not in the middle of collision
+            for (MobID::T mob_id : ANTHOLE_SPAWNS[i])
+                sim->commands().spawn_mob(defender.id, mob_id, defender.get_x(), defender.get_y(),
+                    defender.get_team(), defender.id, defender.target);
         }
     }
     /* yggdrasil revive clause
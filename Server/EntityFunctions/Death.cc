@@ -94,11 +94,12 @@ void entity_on_death(Simulation *sim, Entity const &ent) {
             if (ent.get_loadout_ids(i) != PetalID::kNone && ent.get_loadout_ids(i) != PetalID::kBasic && frand() < 0.95)
                 potential.push_back(ent.get_loadout_ids(i));
         }
-        for (uint32_t i = 0; i < ent.deleted_petals.size(); ++i) {
-            DEBUG_ONLY(assert(ent.deleted_petals[i] < PetalID::kNumPetals));
-            PetalTracker::remove_petal(sim, ent.deleted_petals[i]);
-            if (ent.deleted_petals[i] != PetalID::kNone && ent.deleted_petals[i] != PetalID::kBasic && frand() < 0.95)
-                potential.push_back(ent.deleted_petals[i]);
+        circ_arr_t const &deleted_petals = sim->get_flower_data(ent).deleted_petals;
+        for (uint32_t i = 0; i < deleted_petals.size(); ++i) {
+            DEBUG_ONLY(assert(deleted_petals[i] < PetalID::kNumPetals));
+            PetalTracker::remove_petal(sim, deleted_petals[i]);
+            if (deleted_petals[i] != PetalID::kNone && deleted_petals[i] != PetalID::kBasic && frand() < 0.95)
+                potential.push_back(deleted_petals[i]);
         }
         //no need to deleted_petals.clear, the player dies
         std::sort(potential.begin(), potential.end(), [](PetalID::T a, PetalID::T b) {
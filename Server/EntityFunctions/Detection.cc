@@ -3,23 +3,34 @@
 #include <Shared/Simulation.hh>
 #include <Shared/Entity.hh>
 
+//mobs search every TPS / 5 ticks, staggered by id
+static uint8_t _search_due(Entity const &entity) {
+    return (entity.id.id - entity.lifetime) % (TPS / 5) == 0 && entity.immunity_ticks == 0;
+}
+
 EntityID find_nearest_enemy(Simulation *simulation, Entity const &entity, float radius) {
-    if ((entity.id.id - entity.lifetime) % (TPS / 5) != 0) return NULL_ENTITY;
-    if (entity.immunity_ticks > 0) return NULL_ENTITY;
-    EntityID ret;
-    float min_dist = radius;
-    simulation->spatial_hash.query(entity.get_x(), entity.get_y(), radius, radius, [&](Simulation *sim, Entity &ent){
-        if (!sim->ent_alive(ent.id)) return;
-        if (ent.get_team() == entity.get_team()) return;
-        if (ent.immunity_ticks > 0) return;
-        if (!ent.has_component(kMob) && !ent.has_component(kFlower)) return;
-        if (sim->ent_alive(entity.get_parent())) {
-            Entity &parent = sim->get_ent(entity.get_parent());
-            float dist = Vector(ent.get_x()-parent.get_x(),ent.get_y()-parent.get_y()).magnitude();
-            if (dist > SUMMON_RETREAT_RADIUS) return;
-        }
-        float dist = Vector(ent.get_x()-entity.get_x(),ent.get_y()-entity.get_y()).magnitude();
-        if (dist < min_dist) { min_dist = dist; ret = ent.id; }
+    if (!_search_due(entity)) return NULL_ENTITY;
+    //acquire_targets searched further than this. entities only get deleted between then and
+    //now, so its result is still the nearest unless it was deleted
+    if (radius <= entity.acquired_radius) {
+        if (entity.acquired_target == NULL_ENTITY) return NULL_ENTITY;
+        if (simulation->ent_alive(entity.acquired_target))
+            return entity.acquired_dist < radius ? entity.acquired_target : NULL_ENTITY;
+    }
+    float dist;
+    return simulation->target_index.nearest_enemy(entity, radius, dist);
+}
+
+//only for mobs that are likely to search: tick_ai_behavior still decides, and
+//falls back to searching itself for anything skipped here
+void acquire_targets(Simulation *simulation) {
+    simulation->for_each_parallel<kMob>([](Simulation *sim, Entity &ent) {
+        ent.acquired_radius = 0;
+        if (!_search_due(ent) || ent.detection_radius == 0) return;
+        if (BitMath::at(ent.flags, EntityFlags::kIsCulled)) return;
+        if (sim->ent_alive(ent.seg_head) || sim->ent_alive(ent.target) || sim->ent_alive(ent.last_damaged_by)) return;
+        //the widest radius tick_ai_behavior searches with
+        ent.acquired_radius = ent.detection_radius + ent.get_radius();
+        ent.acquired_target = sim->target_index.nearest_enemy(ent, ent.acquired_radius, ent.acquired_dist);
     });
-    return ret;
-}
\ No newline at end of file
+}
@@ -0,0 +1,61 @@
+#include <Shared/Simulation.hh>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+//prints the offset and size of every Entity field (gardn-entity-layout target)
+//so that layout and size regressions are visible in review
+
+struct FieldInfo {
+    std::string name;
+    uint32_t offset;
+    uint32_t size;
+};
+
+int main() {
+    Simulation *sim = new Simulation();
+    Entity &ent = sim->alloc_ent();
+    //getters assert their component in debug builds
+    for (uint32_t comp = 0; comp < kComponentCount; ++comp)
+        sim->add_component(ent, comp);
+    auto offset_of = [&](void const *field) -> uint32_t {
+        return (uint8_t const *) field - (uint8_t const *) &ent;
+    };
+
+    std::vector<FieldInfo> fields;
+    #define SINGLE(component, name, type) fields.push_back({#name, offset_of(&ent.get_##name()), sizeof(type)});
+    #define MULTIPLE(component, name, type, amt) fields.push_back({#name, offset_of(&ent.get_##name(0)), sizeof(type) * amt});
+    PERFIELD
+    #undef SINGLE
+    #undef MULTIPLE
+    #define SINGLE(name, type, reset) fields.push_back({#name, offset_of(&ent.name), sizeof(type)});
+    #define MULTIPLE(name, type, amt, reset) fields.push_back({#name, offset_of(&ent.name[0]), sizeof(type) * amt});
+    PER_EXTRA_FIELD
+    #undef SINGLE
+    #undef MULTIPLE
+    fields.push_back({"id", offset_of(&ent.id), sizeof(ent.id)});
+    fields.push_back({"pending_delete", offset_of(&ent.pending_delete), sizeof(ent.pending_delete)});
+    fields.push_back({"lifetime", offset_of(&ent.lifetime), sizeof(ent.lifetime)});
+    std::sort(fields.begin(), fields.end(), [](FieldInfo const &a, FieldInfo const &b) {
+        return a.offset < b.offset;
+    });
+
+    std::cout << "Entity Layout: {\n";
+    uint32_t at = 0;
+    for (FieldInfo const &field : fields) {
+        //components, protocol state bitmaps and padding
+        if (field.offset > at)
+            std::cout << "  " << at << " +" << field.offset - at << " (unlisted)\n";
+        std::cout << "  " << field.offset << " +" << field.size << " " << field.name << '\n';
+        at = field.offset + field.size;
+    }
+    if (sizeof(Entity) > at)
+        std::cout << "  " << at << " +" << sizeof(Entity) - at << " (unlisted)\n";
+    std::cout << "}\n";
+    std::cout << "Entity Size: " << sizeof(Entity) << '\n';
+    std::cout << "FlowerData Size: " << sizeof(FlowerData) << '\n';
+    std::cout << "Simulation Size: " << sizeof(Simulation) << '\n';
+    return 0;
+}
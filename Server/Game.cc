@@ -2,64 +2,138 @@
 
 #include <Server/Client.hh>
 #include <Server/PetalTracker.hh>
+#include <Server/Scheduler.hh>
 #include <Server/Server.hh>
 
 #include <Shared/Binary.hh>
 #include <Shared/Entity.hh>
 #include <Shared/Map.hh>
 
-static void _update_client(Simulation *sim, Client *client) {
+#include <algorithm>
+#include <iostream>
+
+//only reads the simulation, so clients can be updated in parallel
+static void _update_client(Simulation *sim, EncodeCache &encode_cache, OutgoingPackets &out, Client *client) {
     if (client == nullptr) return;
     if (!client->verified) return;
     if (sim == nullptr) return;
     if (!sim->ent_exists(client->camera)) return;
-    std::set<EntityID> in_view;
-    std::vector<EntityID> deletes;
-    in_view.insert(client->camera);
-    Entity &camera = sim->get_ent(client->camera);
-    if (sim->ent_exists(camera.get_player())) 
-        in_view.insert(camera.get_player());
-    Writer writer(Server::OUTGOING_PACKET);
+    uint32_t const words = sim->capacity() / 64;
+    if (client->in_view.size() != words) {
+        client->in_view.assign(words, 0);
+        client->in_view_hash.assign(sim->capacity(), 0);
+    }
+    std::vector<uint64_t> &seen = client->in_view;
+    std::vector<EntityID::hash_type> &seen_hash = client->in_view_hash;
+    static thread_local std::vector<uint64_t> in_view;
+    in_view.assign(words, 0);
+    //written first so the room left for creates is known
+    static thread_local std::vector<uint8_t> arena;
+    Writer arena_writer(arena, 0);
+    arena_writer.write<uint8_t>(client->seen_arena);
+    sim->arena_info.write(&arena_writer, client->seen_arena);
+    client->seen_arena = 1;
+    Writer writer(out.bytes, out.used);
     writer.write<uint8_t>(Clientbound::kClientUpdate);
     writer.write<EntityID>(client->camera);
+    //a slot in view since last update can hold a new entity by now: the old one is
+    //deleted right away and the new one is created like any other entity
+    auto mark = [&](EntityID const &id) {
+        if (BitMath::at_arr(seen.data(), id.id) && seen_hash[id.id] != id.hash) {
+            writer.write<EntityID>(EntityID(id.id, seen_hash[id.id]));
+            BitMath::unset_arr(seen.data(), id.id);
+        }
+        BitMath::set_arr(in_view.data(), id.id);
+        seen_hash[id.id] = id.hash;
+    };
+    Entity &camera = sim->get_ent(client->camera);
+    mark(client->camera);
+    if (sim->ent_exists(camera.get_player())) 
+        mark(camera.get_player());
+    static thread_local std::vector<EntityID> visible;
+    visible.clear();
     sim->spatial_hash.query(camera.get_camera_x(), camera.get_camera_y(), 
-    960 / camera.get_fov() + 50, 540 / camera.get_fov() + 50, [&](Simulation *, Entity &ent){
-        in_view.insert(ent.id);
-    });
+    960 / camera.get_fov() + 50, 540 / camera.get_fov() + 50, visible);
+    for (EntityID const &id : visible)
+        mark(id);
 
-    for (EntityID const &i: client->in_view) {
-        if (!in_view.contains(i)) {
-            writer.write<EntityID>(i);
-            deletes.push_back(i);
+    //seen_hash still holds the ids of slots that left view
+    for (uint32_t word = 0; word < words; ++word) {
+        for (uint64_t bits = seen[word] & ~in_view[word]; bits != 0; bits &= bits - 1) {
+            EntityID::id_type const slot = word * 64 + BitMath::ctz(bits);
+            writer.write<EntityID>(EntityID(slot, seen_hash[slot]));
         }
     }
 
-    for (EntityID const &i : deletes)
-        client->in_view.erase(i);
-
     writer.write<EntityID>(NULL_ENTITY);
-    //upcreates
-    for (EntityID id: in_view) {
-        DEBUG_ONLY(assert(sim->ent_exists(id));)
-        Entity &ent = sim->get_ent(id);
-        uint8_t create = !client->in_view.contains(id);
-        writer.write<EntityID>(id);
-        writer.write<uint8_t>(create | (ent.pending_delete << 1));
-        ent.write(&writer, BitMath::at(create, 0));
-        client->in_view.insert(id);
+    //upcreates. deltas first, since the client already has those entities
+    static thread_local std::vector<std::pair<float, EntityID>> creates;
+    creates.clear();
+    for (uint32_t word = 0; word < words; ++word) {
+        for (uint64_t bits = in_view[word] & seen[word]; bits != 0; bits &= bits - 1) {
+            EntityID::id_type const slot = word * 64 + BitMath::ctz(bits);
+            EntityID const id(slot, seen_hash[slot]);
+            DEBUG_ONLY(assert(sim->ent_exists(id));)
+            Entity &ent = sim->get_ent(id);
+            writer.write<EntityID>(id);
+            writer.write<uint8_t>(ent.pending_delete << 1);
+            encode_cache.write(&writer, ent, 0);
+        }
+        for (uint64_t bits = in_view[word] & ~seen[word]; bits != 0; bits &= bits - 1) {
+            EntityID::id_type const slot = word * 64 + BitMath::ctz(bits);
+            EntityID const id(slot, seen_hash[slot]);
+            DEBUG_ONLY(assert(sim->ent_exists(id));)
+            //the camera has no position, and goes first anyway
+            float dist = -1;
+            if (!(id == client->camera)) {
+                Entity const &ent = sim->get_ent(id);
+                Vector const delta(ent.get_x() - camera.get_camera_x(), ent.get_y() - camera.get_camera_y());
+                dist = delta.x * delta.x + delta.y * delta.y;
+            }
+            creates.push_back({ dist, id });
+        }
+        seen[word] &= in_view[word];
+    }
+    //creates can wait: any that would push the packet past what the client reads are
+    //left out of seen and created by a later update
+    uint32_t const room = MAX_PACKET_LEN - arena_writer.size() - 1;
+    uint32_t const creates_start = writer.size();
+    auto write_creates = [&]() {
+        for (uint32_t i = 0; i < creates.size(); ++i) {
+            uint32_t const before = writer.size();
+            Entity &ent = sim->get_ent(creates[i].second);
+            writer.write<EntityID>(ent.id);
+            writer.write<uint8_t>(1 | (ent.pending_delete << 1));
+            encode_cache.write(&writer, ent, 1);
+            if (writer.size() > room) {
+                writer.at = writer.packet + before;
+                return i;
+            }
+        }
+        return (uint32_t) creates.size();
+    };
+    uint32_t sent = write_creates();
+    if (sent < creates.size()) {
+        //a burst (a spawn, a zone change, a low fov): start over, nearest first
+        writer.at = writer.packet + creates_start;
+        std::sort(creates.begin(), creates.end(), [](auto const &a, auto const &b) {
+            return a.first < b.first;
+        });
+        sent = write_creates();
     }
+    for (uint32_t i = 0; i < sent; ++i)
+        BitMath::set_arr(seen.data(), creates[i].second.id);
     writer.write<EntityID>(NULL_ENTITY);
     //write arena stuff
-    writer.write<uint8_t>(client->seen_arena);
-    sim->arena_info.write(&writer, client->seen_arena);
-    client->seen_arena = 1;
-    client->send_packet(writer.packet, writer.at - writer.packet);
+    writer.push(arena.data(), arena_writer.size());
+    out.packets.push_back({ client, out.used, writer.size() });
+    out.used += writer.size();
 }
 
 GameInstance::GameInstance() : simulation(), clients(), team_manager(&simulation) {}
 
 void GameInstance::init() {
-    for (uint32_t i = 0; i < ENTITY_CAP / 2; ++i)
+    for (uint32_t i = 0; i < simulation.capacity() / 2; ++i)
         Map::spawn_random_mob(&simulation, frand() * ARENA_WIDTH, frand() * ARENA_HEIGHT);
     #ifdef GAMEMODE_TDM
     team_manager.add_team(ColorID::kBlue);
@@ -69,8 +143,35 @@ void GameInstance::init() {
 
 void GameInstance::tick() {
     simulation.tick();
-    for (Client *client : clients)
-        _update_client(&simulation, client);
+    uint32_t const threads = Scheduler::thread_count();
+    encode_caches.resize(threads);
+    outgoing.resize(threads);
+    for (uint32_t t = 0; t < threads; ++t) {
+        encode_caches[t].begin_tick(simulation.capacity());
+        outgoing[t].used = 0;
+        outgoing[t].packets.clear();
+    }
+    client_list.assign(clients.begin(), clients.end());
+    //the updates query the grid from every thread, so it must not need sorting by then
+    simulation.spatial_hash.build();
+    //a client update is far more work than an entity, so chunks can be small
+    Scheduler::parallel_for(client_list.size(), [&](uint32_t begin, uint32_t end) {
+        uint32_t const t = Scheduler::thread_index();
+        for (uint32_t i = begin; i < end; ++i)
+            _update_client(&simulation, encode_caches[t], outgoing[t], client_list[i]);
+    }, 1);
+    //sockets may only be used from the thread running the server loop
+    for (OutgoingPackets const &out : outgoing) {
+        for (OutgoingPackets::Packet const &packet : out.packets) {
+            if (packet.length > MAX_PACKET_LEN) {
+                //too big even without creates, and the client cannot read it
+                std::cerr << "Client update overflow (" << packet.length << " bytes)\n";
+                packet.client->disconnect(CloseReason::kServer, "Packet Overflow");
+                continue;
+            }
+            packet.client->send_packet(out.bytes.data() + packet.offset, packet.length);
+        }
+    }
     simulation.post_tick();
 }
 
@@ -81,8 +182,8 @@ void GameInstance::add_client(Client *client) {
     client->game = this;
     clients.insert(client);
     Entity &ent = simulation.alloc_ent();
-    ent.add_component(kCamera);
-    ent.add_component(kRelations);
+    simulation.add_component(ent, kCamera);
+    simulation.add_component(ent, kRelations);
     #ifdef GAMEMODE_TDM
     EntityID team = team_manager.get_random_team();
     ent.set_team(team);
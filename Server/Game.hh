@@ -1,16 +1,35 @@
 #pragma once
 
+#include <Server/EncodeCache.hh>
 #include <Server/TeamManager.hh>
 
 #include <Shared/Simulation.hh>
 
 #include <set>
+#include <vector>
 
 class Client;
 
+//client updates one Scheduler thread built this tick, back to back in bytes
+struct OutgoingPackets {
+    struct Packet {
+        Client *client;
+        uint32_t offset;
+        uint32_t length;
+    };
+    std::vector<uint8_t> bytes;
+    uint32_t used;
+    std::vector<Packet> packets;
+};
+
 class GameInstance {
     std::set<Client *> clients;
     TeamManager team_manager;
+    //client updates are built in parallel, so each Scheduler thread has its own
+    //cache and output. the packets are sent from the calling thread afterwards
+    std::vector<EncodeCache> encode_caches;
+    std::vector<OutgoingPackets> outgoing;
+    std::vector<Client *> client_list;
 public:
     Simulation simulation;
     GameInstance();
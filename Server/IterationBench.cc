@@ -0,0 +1,111 @@
+#include <Server/Scheduler.hh>
+#include <Server/Spawn.hh>
+
+#include <Shared/Map.hh>
+#include <Shared/Simulation.hh>
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+
+//times the component passes of a tick (gardn-iteration-bench target)
+//usage: gardn-iteration-bench [entities] [rounds]
+//the arena is filled with zone mobs (at twice that capacity), then every round visits the same
+//component sets on_tick does, once through std::function callbacks with a has_component
+//check per entity (the way for_each worked before it was templated) and once through
+//for_each. the callback only reads the entity, so both see the same state. exits with 1
+//if they visit different entities
+
+typedef std::chrono::duration<double, std::micro> us_t;
+typedef std::function<void(Simulation *, Entity &)> system_t;
+
+static uint8_t const TICK_PASSES[] = { kCamera, kFlower, kMob, kPetal, kHealth, kPhysics, kSegmented, kCamera, kScore };
+
+struct Visit {
+    uint32_t count = 0;
+    uint64_t id_sum = 0;
+    //reads the entity like a system would
+    float position_sum = 0;
+    void operator()(Simulation *, Entity &ent) {
+        ++count;
+        id_sum += ent.id.id;
+        position_sum += ent.get_x();
+    }
+};
+
+//the iteration for_each_entity and for_each did with std::function
+static void _function_for_each_entity(Simulation *sim, system_t const &cb) {
+    sim->for_each_entity(cb);
+}
+
+static void _function_for_each(Simulation *sim, uint8_t comp, system_t const &cb) {
+    _function_for_each_entity(sim, [&](Simulation *sim, Entity &ent) {
+        if (ent.has_component(comp)) cb(sim, ent);
+    });
+}
+
+static void _function_tick(Simulation *sim, Visit &visit) {
+    system_t cb = std::ref(visit);
+    for (uint8_t comp : TICK_PASSES)
+        _function_for_each(sim, comp, cb);
+    _function_for_each_entity(sim, cb);
+}
+
+template <uint8_t comp>
+static void _templated_pass(Simulation *sim, Visit &visit) {
+    sim->for_each<comp>([&](Simulation *sim, Entity &ent) { visit(sim, ent); });
+}
+
+static void _templated_tick(Simulation *sim, Visit &visit) {
+    _templated_pass<kCamera>(sim, visit);
+    _templated_pass<kFlower>(sim, visit);
+    _templated_pass<kMob>(sim, visit);
+    _templated_pass<kPetal>(sim, visit);
+    _templated_pass<kHealth>(sim, visit);
+    _templated_pass<kPhysics>(sim, visit);
+    _templated_pass<kSegmented>(sim, visit);
+    _templated_pass<kCamera>(sim, visit);
+    _templated_pass<kScore>(sim, visit);
+    sim->for_each_entity([&](Simulation *sim, Entity &ent) { visit(sim, ent); });
+}
+
+int main(int argc, char **argv) {
+    uint32_t target = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 8192;
+    uint32_t rounds = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000;
+    Scheduler::init(1);
+    seed_frand(0);
+    Simulation *sim = new Simulation();
+    sim->set_capacity(2 * target);
+    //ticks in between so every entity counts as alive at the start of a tick
+    Visit entities;
+    while (entities.count < target) {
+        for (uint32_t i = 0; i < 64; ++i) {
+            float x = frand() * ARENA_WIDTH, y = frand() * ARENA_HEIGHT;
+            alloc_mob(sim, Map::random_zone_mob(Map::get_zone_from_pos(x, y)), x, y, NULL_ENTITY);
+        }
+        sim->tick();
+        sim->post_tick();
+        entities = {};
+        sim->for_each_entity([&](Simulation *sim, Entity &ent) { entities(sim, ent); });
+    }
+    Visit function_visit, templated_visit;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < rounds; ++i)
+        _function_tick(sim, function_visit);
+    us_t function_time = std::chrono::steady_clock::now() - start;
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < rounds; ++i)
+        _templated_tick(sim, templated_visit);
+    us_t templated_time = std::chrono::steady_clock::now() - start;
+    std::cout << "Entity Capacity: " << sim->capacity() << '\n';
+    std::cout << "Entities: " << entities.count << '\n';
+    std::cout << "Visits/round: " << templated_visit.count / rounds << '\n';
+    std::cout << "std::function: " << function_time.count() / rounds << " us/round\n";
+    std::cout << "templated: " << templated_time.count() / rounds << " us/round\n";
+    if (function_visit.count != templated_visit.count || function_visit.id_sum != templated_visit.id_sum) {
+        std::cout << "MISMATCH: " << function_visit.count << " vs " << templated_visit.count << " visits\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,108 @@
+#include <Server/Process.hh>
+#include <Server/Scheduler.hh>
+#include <Server/Spawn.hh>
+
+#include <Shared/Map.hh>
+#include <Shared/Simulation.hh>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+//times the two passes that touch every physics entity every tick, motion and collision
+//(gardn-layout-bench target), to compare Entity layouts. build it as is and with
+//DECLARED_ENTITY_LAYOUT (gardn-layout-bench-declared, see layout-bench-compare)
+//usage: gardn-layout-bench [entities] [rounds]
+//the arena is filled with zone mobs at random positions (so neighbours in the grid are not
+//neighbours in memory), then every round rebuilds the grid, collides and moves everything.
+//the minimum over rounds is reported. collision commands are dropped, so nothing dies and
+//every round does the same amount of work. both layouts simulate the same thing, so the
+//checksum should match between them. exits with 1 if the per-tick fields do not fit the
+//first two cache lines of Entity
+
+typedef std::chrono::duration<double, std::micro> us_t;
+
+static uint32_t const HOT_BYTES = 128;
+
+//end of the last per-tick field, in bytes from the start of the entity
+static uint32_t _hot_end(Simulation *sim) {
+    Entity &ent = sim->alloc_ent();
+    for (uint32_t comp = 0; comp < kComponentCount; ++comp)
+        sim->add_component(ent, comp);
+    uint32_t end = 0;
+    auto extend = [&](void const *field, uint32_t size) {
+        end = std::max(end, (uint32_t) ((uint8_t const *) field - (uint8_t const *) &ent) + size);
+    };
+    #define SINGLE(component, name, type) extend(&ent.get_##name(), sizeof(type));
+    #define MULTIPLE(component, name, type, amt) extend(&ent.get_##name(0), sizeof(type) * amt);
+    PERFIELD_HOT
+    #undef SINGLE
+    #undef MULTIPLE
+    #define SINGLE(name, type, reset) extend(&ent.name, sizeof(type));
+    #define MULTIPLE(name, type, amt, reset) extend(&ent.name[0], sizeof(type) * amt);
+    PER_EXTRA_FIELD_HOT
+    #undef SINGLE
+    #undef MULTIPLE
+    extend(&ent.id, sizeof(ent.id));
+    extend(&ent.pending_delete, sizeof(ent.pending_delete));
+    sim->_delete_ent(ent.id);
+    return end;
+}
+
+int main(int argc, char **argv) {
+    uint32_t target = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 32768;
+    uint32_t rounds = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 50;
+    Scheduler::init(1);
+    seed_frand(0);
+    Simulation *sim = new Simulation();
+    sim->set_capacity(2 * target);
+    uint32_t const hot_end = _hot_end(sim);
+    for (uint32_t i = 0; i < target; ++i) {
+        float x = frand() * ARENA_WIDTH, y = frand() * ARENA_HEIGHT;
+        alloc_mob(sim, Map::random_zone_mob(Map::get_zone_from_pos(x, y)), x, y, NULL_ENTITY);
+    }
+    //one tick so every entity counts as alive at the start of a tick
+    sim->tick();
+    sim->post_tick();
+    sim->spatial_hash.refresh(ARENA_WIDTH, ARENA_HEIGHT);
+
+    us_t motion_time = us_t::max(), collide_time = us_t::max();
+    for (uint32_t round = 0; round < rounds; ++round) {
+        sim->spatial_hash.begin_tick();
+        sim->for_each<kPhysics>([](Simulation *sim, Entity &ent) { sim->spatial_hash.insert(ent); });
+        sim->spatial_hash.build();
+        auto start = std::chrono::steady_clock::now();
+        sim->spatial_hash.collide(on_collide);
+        auto collided = std::chrono::steady_clock::now();
+        sim->commands().clear();
+        sim->for_each<kPhysics>(tick_entity_motion);
+        auto moved = std::chrono::steady_clock::now();
+        collide_time = std::min(collide_time, us_t(collided - start));
+        motion_time = std::min(motion_time, us_t(moved - collided));
+    }
+    uint64_t checksum = 0;
+    sim->for_each<kPhysics>([&](Simulation *, Entity &ent) {
+        uint32_t x, y;
+        float fx = ent.get_x(), fy = ent.get_y();
+        std::memcpy(&x, &fx, sizeof(x));
+        std::memcpy(&y, &fy, sizeof(y));
+        checksum = checksum * 31 + ent.id.id;
+        checksum = checksum * 31 + x;
+        checksum = checksum * 31 + y;
+    });
+    std::cout << "Entity Size: " << sizeof(Entity) << '\n';
+    std::cout << "Per-tick fields end at: " << hot_end << '\n';
+    std::cout << "Entities: " << target << '\n';
+    std::cout << "tick_entity_motion: " << motion_time.count() << " us (min)\n";
+    std::cout << "SpatialHash::collide: " << collide_time.count() << " us (min)\n";
+    std::cout << "Checksum: " << std::hex << checksum << std::dec << '\n';
+#ifndef DECLARED_ENTITY_LAYOUT
+    if (hot_end > HOT_BYTES) {
+        std::cout << "per-tick fields end past byte " << HOT_BYTES << '\n';
+        return 1;
+    }
+#endif
+    return 0;
+}
@@ -1,16 +1,32 @@
 #include <Shared/Simulation.hh>
+#include <Server/Scheduler.hh>
 #include <Server/Server.hh>
 
+#include <cstdlib>
+#include <ctime>
 #include <iostream>
 
-int main() {
+int main(int argc, char **argv) {
+    //usage: gardn-server [entity capacity] [threads, 0 for one per core]
+    uint64_t entity_cap = DEFAULT_ENTITY_CAP;
+    if (argc > 1) {
+        entity_cap = std::strtoull(argv[1], nullptr, 10);
+        if (entity_cap == 0 || entity_cap > MAX_ENTITY_CAP) {
+            std::cout << "invalid entity capacity " << argv[1] << " (1 to " << MAX_ENTITY_CAP << ")\n";
+            return 1;
+        }
+    }
+    //before set_capacity, which sizes the per-thread command buffers
+    Scheduler::init(argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 0);
+    Server::game.simulation.set_capacity(entity_cap);
     std::cout << "Diagnostics: {\n";
     std::cout << "  Simulation Size: " << sizeof(Simulation) << '\n';
     std::cout << "  Spatial Hash Size: " << sizeof(SpatialHash) << '\n';
     std::cout << "  Entity Size: " << sizeof(Entity) << '\n';
+    std::cout << "  Entity Capacity: " << Server::game.simulation.capacity() << '\n';
+    std::cout << "  Threads: " << Scheduler::thread_count() << '\n';
     std::cout << "}\n";
-    srand(std::time(0));
+    seed_frand(std::time(0));
     Server::init();
     return 0;
 }
-
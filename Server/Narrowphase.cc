@@ -0,0 +1,77 @@
+#include <Server/Narrowphase.hh>
+
+#include <Helpers/Bits.hh>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define NARROWPHASE_X86 1
+#include <immintrin.h>
+#endif
+
+using namespace Narrowphase;
+
+//the vector kernels finish their spans with this, and do the same operations
+//in the same order per lane, so every kernel returns exactly what this one does
+static uint32_t _scalar_from(uint32_t i, float x, float y, float r, float const *xs, float const *ys, float const *rs, uint32_t count, uint32_t *out) {
+    uint32_t n = 0;
+    for (; i < count; ++i) {
+        float dx = xs[i] - x, dy = ys[i] - y, s = rs[i] + r;
+        if (dx * dx + dy * dy <= s * s) out[n++] = i;
+    }
+    return n;
+}
+
+static uint32_t _scalar(float x, float y, float r, float const *xs, float const *ys, float const *rs, uint32_t count, uint32_t *out) {
+    return _scalar_from(0, x, y, r, xs, ys, rs, count, out);
+}
+
+#ifdef NARROWPHASE_X86
+__attribute__((target("sse2")))
+static uint32_t _sse2(float x, float y, float r, float const *xs, float const *ys, float const *rs, uint32_t count, uint32_t *out) {
+    __m128 const vx = _mm_set1_ps(x), vy = _mm_set1_ps(y), vr = _mm_set1_ps(r);
+    uint32_t n = 0, i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(xs + i), vx);
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(ys + i), vy);
+        __m128 s = _mm_add_ps(_mm_loadu_ps(rs + i), vr);
+        __m128 dist = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        for (uint32_t mask = _mm_movemask_ps(_mm_cmple_ps(dist, _mm_mul_ps(s, s))); mask; mask &= mask - 1)
+            out[n++] = i + BitMath::ctz(mask);
+    }
+    return n + _scalar_from(i, x, y, r, xs, ys, rs, count, out + n);
+}
+
+__attribute__((target("avx2")))
+static uint32_t _avx2(float x, float y, float r, float const *xs, float const *ys, float const *rs, uint32_t count, uint32_t *out) {
+    __m256 const vx = _mm256_set1_ps(x), vy = _mm256_set1_ps(y), vr = _mm256_set1_ps(r);
+    uint32_t n = 0, i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(xs + i), vx);
+        __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(ys + i), vy);
+        __m256 s = _mm256_add_ps(_mm256_loadu_ps(rs + i), vr);
+        __m256 dist = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+        for (uint32_t mask = _mm256_movemask_ps(_mm256_cmp_ps(dist, _mm256_mul_ps(s, s), _CMP_LE_OQ)); mask; mask &= mask - 1)
+            out[n++] = i + BitMath::ctz(mask);
+    }
+    return n + _scalar_from(i, x, y, r, xs, ys, rs, count, out + n);
+}
+#endif
+
+static std::vector<KernelInfo> _detect() {
+    std::vector<KernelInfo> kernels = {{ "scalar", _scalar }};
+#ifdef NARROWPHASE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) kernels.push_back({ "sse2", _sse2 });
+    if (__builtin_cpu_supports("avx2")) kernels.push_back({ "avx2", _avx2 });
+#endif
+    return kernels;
+}
+
+std::vector<KernelInfo> const &Narrowphase::available() {
+    static std::vector<KernelInfo> const kernels = _detect();
+    return kernels;
+}
+
+KernelInfo const &Narrowphase::selected() {
+    static KernelInfo const best = available().back();
+    return best;
+}
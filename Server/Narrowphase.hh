@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+//circle overlap tests over one circle against a span of candidates, used by SpatialHash::collide
+//candidates are passed as separate x, y and radius arrays so the kernels can load 4 or 8 at a time
+namespace Narrowphase {
+    //x, y, r, xs, ys, rs, count, out
+    //writes the index of every candidate in [0, count) that overlaps (x, y, r) to out,
+    //in increasing order, and returns how many. touching counts as overlapping
+    typedef uint32_t (*Kernel)(float, float, float, float const *, float const *, float const *, uint32_t, uint32_t *);
+    struct KernelInfo {
+        char const *name;
+        Kernel kernel;
+    };
+    //the kernels this cpu can run, scalar first and the widest last
+    std::vector<KernelInfo> const &available();
+    //the widest available kernel, picked once
+    KernelInfo const &selected();
+}
@@ -0,0 +1,69 @@
+#include <Server/Narrowphase.hh>
+
+#include <Helpers/Math.hh>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+//checks every Narrowphase kernel this cpu has against the scalar one, then times them
+//(gardn-narrowphase-bench target). exits with 1 if any kernel disagrees
+//usage: gardn-narrowphase-bench [span length] [rounds]
+//circles are scattered over a 3x3 block of grid cells with radii of 10-50,
+//about what one entity is tested against in SpatialHash::collide
+
+static uint32_t const CHECK_ROUNDS = 100000;
+static uint32_t const MAX_CHECK_SPAN = 64;
+static float const BLOCK_SIZE = 600;
+
+typedef std::chrono::duration<double, std::nano> ns_t;
+
+int main(int argc, char **argv) {
+    uint32_t span = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 32;
+    uint32_t rounds = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000000;
+    seed_frand(0);
+    uint32_t const size = std::max(span, MAX_CHECK_SPAN) + 1;
+    std::vector<float> xs(size), ys(size), rs(size);
+    for (uint32_t i = 0; i < size; ++i) {
+        xs[i] = frand() * BLOCK_SIZE;
+        ys[i] = frand() * BLOCK_SIZE;
+        rs[i] = 10 + frand() * 40;
+    }
+    std::vector<uint32_t> expected(size), got(size);
+    std::vector<Narrowphase::KernelInfo> const &kernels = Narrowphase::available();
+    Narrowphase::Kernel const scalar = kernels[0].kernel;
+    int status = 0;
+    //every length and misaligned starts, so the vector bodies and scalar tails are both covered
+    for (Narrowphase::KernelInfo const &info : kernels) {
+        uint32_t mismatches = 0;
+        for (uint32_t round = 0; round < CHECK_ROUNDS; ++round) {
+            uint32_t begin = round % 2, count = round % MAX_CHECK_SPAN;
+            float x = frand() * BLOCK_SIZE, y = frand() * BLOCK_SIZE, r = 10 + frand() * 40;
+            //exactly touching one candidate
+            if (round % 3 == 0 && count > 0) x = xs[begin] + rs[begin] + r, y = ys[begin];
+            uint32_t n = scalar(x, y, r, &xs[begin], &ys[begin], &rs[begin], count, expected.data());
+            uint32_t m = info.kernel(x, y, r, &xs[begin], &ys[begin], &rs[begin], count, got.data());
+            if (n != m || !std::equal(expected.begin(), expected.begin() + n, got.begin())) ++mismatches;
+        }
+        std::cout << info.name << ": " << (mismatches ? "MISMATCH " : "ok ") << mismatches << '/' << CHECK_ROUNDS << '\n';
+        if (mismatches) status = 1;
+    }
+    std::cout << "Span: " << span << '\n';
+    std::cout << "Selected: " << Narrowphase::selected().name << '\n';
+    for (Narrowphase::KernelInfo const &info : kernels) {
+        uint64_t hits = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t round = 0; round < rounds; ++round) {
+            //walk the query circle around so the branch on hits is not predictable
+            uint32_t i = round % size;
+            hits += info.kernel(xs[i], ys[i], rs[i], xs.data(), ys.data(), rs.data(), span, got.data());
+        }
+        ns_t elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << info.name << ": " << elapsed.count() / rounds << " ns/span, "
+            << elapsed.count() / ((double) rounds * span) << " ns/candidate, "
+            << (double) hits / rounds << " hits/span\n";
+    }
+    return status;
+}
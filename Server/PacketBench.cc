@@ -0,0 +1,248 @@
+#include <Server/Client.hh>
+#include <Server/EncodeCache.hh>
+#include <Server/Scheduler.hh>
+#include <Server/Server.hh>
+#include <Server/Spawn.hh>
+
+#include <Shared/Binary.hh>
+#include <Shared/Simulation.hh>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <set>
+#include <vector>
+
+//times the entity part of client updates (gardn-packet-bench target)
+//usage: gardn-packet-bench [clients] [entity capacity] [ticks] [threads, 0 for one per core]
+//every client spawns at level 1, in the same zone, and is then moved into one crowd about
+//a screen across, so every entity near them is sent to most of the clients. each tick, every
+//client's entities are written once with Entity::write per client and once through an
+//EncodeCache, and the two packets are compared. the cached packet is then decoded the way
+//the client's Entity::read would, and every position must be within 1/128 of the server's,
+//every angle within pi/256 and every health ratio within a step. exits with 1 if the packets
+//differ or anything decodes out of those bounds.
+//then times whole GameInstance ticks with the same clients, which build their updates in parallel
+
+static float const CROWD_WIDTH = 1600;
+static float const CROWD_HEIGHT = 900;
+
+//float rounding on top of the wire format's own error
+static float const DECODE_SLACK = 1e-4;
+
+typedef std::chrono::duration<double, std::milli> ms_t;
+
+//Entity's field ids, which it keeps private
+enum BenchField {
+    #define SINGLE(component, name, type) kField_##name,
+    #define MULTIPLE(component, name, type, amt) kField_##name,
+    PERFIELD
+    #undef SINGLE
+    #undef MULTIPLE
+    kFieldEnd
+};
+
+//the quantized fields of one entity, as a client's Entity::read leaves them
+struct BenchDecoded {
+    uint32_t components = 0;
+    int32_t wire_x = 0;
+    int32_t wire_y = 0;
+    float x = 0;
+    float y = 0;
+    float angle = 0;
+    float health_ratio = 0;
+};
+
+struct BenchView {
+    Client *client;
+    std::set<EntityID> in_view;
+    std::map<EntityID, BenchDecoded> decoded = {};
+};
+
+//Entity::read_field, keeping only the quantized fields
+template<uint32_t field, typename T>
+static void _read_field(Reader &reader, BenchDecoded &decoded, uint8_t create) {
+    if constexpr (field == kField_angle)
+        decoded.angle = reader.read<uint8_t>() / EntityWire::ANGLE_SCALE;
+    else if constexpr (field == kField_health_ratio)
+        decoded.health_ratio = reader.read<uint8_t>() / EntityWire::RATIO_SCALE;
+    else if constexpr (field == kField_x || field == kField_y) {
+        int32_t &wire = field == kField_x ? decoded.wire_x : decoded.wire_y;
+        if (create) wire = 0;
+        wire += reader.read<int32_t>();
+        (field == kField_x ? decoded.x : decoded.y) = wire / EntityWire::POSITION_SCALE;
+    } else {
+        T v;
+        reader.read<T>(v);
+    }
+}
+
+//Entity::read<true> and Entity::read<false>
+static void _decode(Reader &reader, BenchDecoded &decoded, uint8_t create) {
+    if (create) {
+        decoded = {};
+        decoded.components = reader.read<uint32_t>();
+        //lifetime
+        reader.read<uint32_t>();
+        #define SINGLE(component, name, type) { _read_field<kField_##name, type>(reader, decoded, 1); }
+        #define MULTIPLE(component, name, type, amt) { \
+            for (uint32_t n = 0; n < amt; ++n) { \
+                type v; \
+                reader.read<type>(v); \
+            } \
+        }
+        #define COMPONENT(name) if (BitMath::at(decoded.components, k##name)) { FIELDS_##name }
+        PERCOMPONENT
+        #undef SINGLE
+        #undef MULTIPLE
+        #undef COMPONENT
+        return;
+    }
+    while (1) {
+        switch (reader.read<uint8_t>()) {
+            case kFieldEnd: { return; }
+            #define SINGLE(component, name, type) case kField_##name: { \
+                _read_field<kField_##name, type>(reader, decoded, 0); \
+                break; \
+            }
+            #define MULTIPLE(component, name, type, amt) case kField_##name: { \
+                while (reader.read<uint8_t>() < amt) { \
+                    type v; \
+                    reader.read<type>(v); \
+                } \
+                break; \
+            }
+            PERFIELD
+            #undef SINGLE
+            #undef MULTIPLE
+        }
+    }
+}
+
+//whether what the client decoded is as close to ent as the wire format allows
+static uint8_t _decoded_matches(BenchDecoded const &decoded, Entity const &ent) {
+    if (ent.has_component(kPhysics)) {
+        if (std::abs(decoded.x - ent.get_x()) > 1 / (2 * EntityWire::POSITION_SCALE)) return 0;
+        if (std::abs(decoded.y - ent.get_y()) > 1 / (2 * EntityWire::POSITION_SCALE)) return 0;
+        float const turn = std::remainder(decoded.angle - ent.get_angle(), 2 * M_PI);
+        if (std::abs(turn) > M_PI / 256 + DECODE_SLACK) return 0;
+    }
+    if (ent.has_component(kHealth)) {
+        float const ratio = fclamp(ent.get_health_ratio(), 0, 1);
+        if (std::abs(decoded.health_ratio - ratio) > 1 / EntityWire::RATIO_SCALE + DECODE_SLACK) return 0;
+    }
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    uint32_t num_clients = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100;
+    uint32_t entity_cap = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 16384;
+    uint32_t ticks = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 10 * TPS;
+    uint32_t threads = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 0;
+    Scheduler::init(threads);
+    seed_frand(0);
+    Simulation *sim = &Server::game.simulation;
+    sim->set_capacity(entity_cap);
+    Server::game.init();
+    std::vector<BenchView> views;
+    for (uint32_t i = 0; i < num_clients; ++i) {
+        //no socket, so nothing is actually sent
+        Client *client = new Client();
+        client->ws = nullptr;
+        client->verified = 1;
+        Server::game.add_client(client);
+        Entity &camera = sim->get_ent(client->camera);
+        Entity &player = alloc_player(sim, camera.get_team());
+        player_spawn(sim, camera, player);
+        if (!views.empty()) {
+            Entity const &first = sim->get_ent(sim->get_ent(views[0].client->camera).get_player());
+            player.set_x(first.get_x() + (frand() - 0.5f) * CROWD_WIDTH);
+            player.set_y(first.get_y() + (frand() - 0.5f) * CROWD_HEIGHT);
+            camera.set_camera_x(player.get_x());
+            camera.set_camera_y(player.get_y());
+        }
+        views.push_back({ client, {} });
+    }
+    //let the petals spawn and the cameras catch up
+    for (uint32_t i = 0; i < TPS; ++i)
+        Server::game.tick();
+
+    ms_t per_client_time(0), cached_time(0);
+    uint64_t entities_written = 0, bytes_written = 0, mismatches = 0, decode_mismatches = 0;
+    EncodeCache encode_cache;
+    std::vector<EntityID> visible;
+    std::vector<uint8_t> per_client_packet, cached_packet;
+    for (uint32_t tick = 0; tick < ticks; ++tick) {
+        sim->tick();
+        sim->spatial_hash.build();
+        encode_cache.begin_tick(sim->capacity());
+        for (BenchView &view : views) {
+            if (!sim->ent_exists(view.client->camera)) continue;
+            //the same entities _update_client sends
+            std::set<EntityID> in_view;
+            Entity &camera = sim->get_ent(view.client->camera);
+            in_view.insert(camera.id);
+            if (sim->ent_exists(camera.get_player())) in_view.insert(camera.get_player());
+            visible.clear();
+            sim->spatial_hash.query(camera.get_camera_x(), camera.get_camera_y(),
+                960 / camera.get_fov() + 50, 540 / camera.get_fov() + 50, visible);
+            in_view.insert(visible.begin(), visible.end());
+            auto start = std::chrono::steady_clock::now();
+            Writer per_client(per_client_packet, 0);
+            for (EntityID const &id : in_view) {
+                Entity &ent = sim->get_ent(id);
+                uint8_t create = !view.in_view.contains(id);
+                per_client.write<EntityID>(id);
+                per_client.write<uint8_t>(create | (ent.pending_delete << 1));
+                ent.write(&per_client, create);
+            }
+            auto written = std::chrono::steady_clock::now();
+            Writer cached(cached_packet, 0);
+            for (EntityID const &id : in_view) {
+                Entity &ent = sim->get_ent(id);
+                uint8_t create = !view.in_view.contains(id);
+                cached.write<EntityID>(id);
+                cached.write<uint8_t>(create | (ent.pending_delete << 1));
+                encode_cache.write(&cached, ent, create);
+            }
+            auto copied = std::chrono::steady_clock::now();
+            per_client_time += written - start;
+            cached_time += copied - written;
+            uint32_t const length = per_client.size();
+            if (length != cached.size() || std::memcmp(per_client.packet, cached.packet, length) != 0)
+                ++mismatches;
+            Reader reader(cached.packet);
+            for (EntityID const &id : in_view) {
+                if (!(reader.read<EntityID>() == id)) {
+                    ++decode_mismatches;
+                    break;
+                }
+                uint8_t const create = reader.read<uint8_t>() & 1;
+                BenchDecoded &decoded = view.decoded[id];
+                _decode(reader, decoded, create);
+                if (!_decoded_matches(decoded, sim->get_ent(id))) ++decode_mismatches;
+            }
+            entities_written += in_view.size();
+            bytes_written += length;
+            view.in_view = std::move(in_view);
+        }
+        sim->post_tick();
+    }
+    std::cout << "Threads: " << Scheduler::thread_count() << '\n';
+    std::cout << "Clients: " << num_clients << '\n';
+    std::cout << "Entities written/tick: " << (double) entities_written / ticks
+        << ", bytes/tick: " << (double) bytes_written / ticks
+        << ", bytes/client/tick: " << (double) bytes_written / ticks / num_clients << '\n';
+    std::cout << "Mismatches: " << mismatches << ", decoded out of bounds: " << decode_mismatches << '\n';
+    std::cout << "ms/tick Entity::write per client: " << per_client_time.count() / ticks << '\n';
+    std::cout << "ms/tick EncodeCache: " << cached_time.count() / ticks << '\n';
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t tick = 0; tick < ticks; ++tick)
+        Server::game.tick();
+    ms_t elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "ms/tick GameInstance::tick: " << elapsed.count() / ticks << '\n';
+    return mismatches > 0 || decode_mismatches > 0;
+}
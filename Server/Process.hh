@@ -3,15 +3,23 @@
 class Simulation;
 class Entity;
 
-void tick_ai_behavior(Simulation *, Entity &);
 void tick_camera_behavior(Simulation *, Entity &);
 void tick_curse_behavior(Simulation *);
+//only clears the kIsCulled flag of what the camera sees, atomically, so cameras can be culled in parallel
 void tick_culling_behavior(Simulation *, Entity &);
 void tick_drop_behavior(Simulation *, Entity &);
-void tick_entity_motion(Simulation *, Entity &);
 void tick_health_behavior(Simulation *, Entity &);
 void tick_petal_behavior(Simulation *, Entity &);
 void tick_player_behavior(Simulation *, Entity &);
 void tick_segment_behavior(Simulation *, Entity &);
-void tick_score_behavior(Simulation *, Entity &);
+//sandstorms follow their parent's acceleration as of a serial pass over mobs: the
+//snapshot runs before the ai, the follow after it, both serially in slot order
+void tick_sandstorm_snapshot(Simulation *, Entity &);
+void tick_sandstorm_follow(Simulation *, Entity &);
 void on_collide(Simulation *, Entity &, Entity &);
+
+//only write the entity they are called on, the rest goes through Simulation::commands()
+//so run_systems can run them in parallel
+void tick_ai_behavior(Simulation *, Entity &);
+void tick_entity_motion(Simulation *, Entity &);
+void tick_score_behavior(Simulation *, Entity &);
@@ -1,7 +1,6 @@
 #include <Server/Process.hh>
 
 #include <Server/EntityFunctions.hh>
-#include <Server/Spawn.hh>
 #include <Shared/Entity.hh>
 #include <Shared/Simulation.hh>
 #include <Shared/StaticData.hh>
@@ -156,15 +155,7 @@ static void tick_hornet_aggro(Simulation *sim, Entity &ent) {
         ent.set_angle(v.angle());
         if (ent.ai_tick >= 1.5 * TPS && dist < 800) {
             ent.ai_tick = 0;
-            //spawn missile;
-            Entity &missile = alloc_petal(sim, PetalID::kMissile, ent);
-            missile.damage = 10;
-            missile.health = missile.max_health = 10;
-            //missile.health = missile.max_health = 20;
-            //missile.despawn_tick = 1;
-            entity_set_despawn_tick(missile, 3 * TPS);
-            missile.set_angle(ent.get_angle());
-            missile.acceleration.unit_normal(ent.get_angle()).set_magnitude(40 * PLAYER_ACCELERATION);
+            sim->commands().spawn_missile(ent.id, ent.id, ent.get_angle());
             Vector kb;
             kb.unit_normal(ent.get_angle() - M_PI).set_magnitude(2.5 * PLAYER_ACCELERATION);
             ent.velocity += kb;            
@@ -308,10 +299,10 @@ static void tick_sandstorm(Simulation *sim, Entity &ent) {
             ent.ai_state = AIState::kIdle;
             break;
     }
-    if (sim->ent_alive(ent.get_parent())) {
-        Entity &parent = sim->get_ent(ent.get_parent());
-        ent.acceleration = (ent.acceleration + parent.acceleration) * 0.75;
-    }
+    //the parent's acceleration may be written by the same pass, so
+    //tick_sandstorm_follow adds it once the pass is done
+    if (sim->ent_alive(ent.get_parent()))
+        BitMath::set(ent.flags, EntityFlags::kFollowsParent);
 }
 
 static void tick_digger(Simulation *sim, Entity &ent) {
@@ -364,7 +355,7 @@ void tick_ai_behavior(Simulation *sim, Entity &ent) {
     if (!(ent.get_parent() == NULL_ENTITY)) {
         if (!sim->ent_alive(ent.get_parent())) {
             if (BitMath::at(ent.flags, EntityFlags::kDieOnParentDeath))
-                sim->request_delete(ent.id);
+                sim->commands().request_delete(ent.id, ent.id);
             ent.set_parent(NULL_ENTITY);
         } else {
             Entity const &parent = sim->get_ent(ent.get_parent());
@@ -421,7 +412,7 @@ void tick_ai_behavior(Simulation *sim, Entity &ent) {
             break;
         case MobID::kSpider:
             if (ent.lifetime % (TPS) == 0) 
-                alloc_web(sim, 25, ent);
+                sim->commands().spawn_web(ent.id, ent.id, 25);
             tick_default_aggro(sim, ent, 1.20);
             break;
         case MobID::kQueenAnt:
@@ -429,9 +420,8 @@ void tick_ai_behavior(Simulation *sim, Entity &ent) {
                 Vector behind;
                 behind.unit_normal(ent.get_angle() + M_PI);
                 behind *= ent.get_radius();
-                Entity &spawned = alloc_mob(sim, MobID::kSoldierAnt, ent.get_x() + behind.x, ent.get_y() + behind.y, ent.get_team());
-                entity_set_despawn_tick(spawned, 10 * TPS);
-                spawned.set_parent(ent.get_parent());
+                sim->commands().spawn_mob(ent.id, MobID::kSoldierAnt, ent.get_x() + behind.x, ent.get_y() + behind.y,
+                    ent.get_team(), ent.get_parent(), NULL_ENTITY, 10 * TPS);
             }
             tick_default_aggro(sim, ent, 0.95);
             break;
@@ -463,4 +453,20 @@ void tick_ai_behavior(Simulation *sim, Entity &ent) {
             ent.set_angle(0 - ent.get_angle());
     }
     ++ent.ai_tick;
-}
\ No newline at end of file
+}
+
+void tick_sandstorm_snapshot(Simulation *sim, Entity &ent) {
+    if (ent.get_mob_id() != MobID::kSandstorm) return;
+    if (sim->ent_alive(ent.get_parent()))
+        ent.parent_acceleration = sim->get_ent(ent.get_parent()).acceleration;
+}
+
+//a parent in an earlier slot has already had its ai run this tick (and its own follow
+//applied), one in a later slot has not, which is what the snapshot holds
+void tick_sandstorm_follow(Simulation *sim, Entity &ent) {
+    if (!BitMath::at(ent.flags, EntityFlags::kFollowsParent)) return;
+    BitMath::unset(ent.flags, EntityFlags::kFollowsParent);
+    Entity const &parent = sim->get_ent(ent.get_parent());
+    Vector const &parent_acceleration = parent.id.id < ent.id.id ? parent.acceleration : ent.parent_acceleration;
+    ent.acceleration = (ent.acceleration + parent_acceleration) * 0.75;
+}
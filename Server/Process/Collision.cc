@@ -7,30 +7,17 @@
 #include <iostream>
 
 static bool _should_interact(Entity const &ent1, Entity const &ent2) {
-    //if (ent1.has_component(kFlower) || ent2.has_component(kFlower)) return false;
-    //if (ent1.has_component(kPetal) || ent2.has_component(kPetal)) return false;
     if (ent1.pending_delete || ent2.pending_delete) return false;
-    if (!(ent1.get_team() == ent2.get_team())) return true;
-    if (BitMath::at((ent1.flags | ent2.flags), EntityFlags::kNoFriendlyCollision)) return false;
-    //if (ent1.has_component(kPetal) || ent2.has_component(kPetal)) return false;
-    if (ent1.has_component(kMob) && ent2.has_component(kMob)) return true;
-    return false;
+    //the grid already applies this, but SpatialHashCanonical does not
+    return collision_filters_interact(CollisionFilter(ent1), CollisionFilter(ent2));
 }
 
+//the loadout slot is picked when the command is applied, so two drops taken in
+//the same tick do not land in the same slot
 static void _pickup_drop(Simulation *sim, Entity &player, Entity &drop) {
     if (!sim->ent_alive(player.get_parent())) return;
     if (drop.immunity_ticks > 0) return;
-
-    for (uint32_t i = 0; i <  player.get_loadout_count() + MAX_SLOT_COUNT; ++i) {
-        if (player.get_loadout_ids(i) != PetalID::kNone) continue;
-        player.set_loadout_ids(i, drop.get_drop_id());
-        drop.set_x(player.get_x());
-        drop.set_y(player.get_y());
-        BitMath::unset(drop.flags, EntityFlags::kIsDespawning);
-        sim->request_delete(drop.id);
-        //peaceful transfer, no petal tracking needed
-        return;
-    }
+    sim->commands().pickup_drop(player.id, player.id, drop.id);
 }
 
 #define NO(component) (!ent1.has_component(component) && !ent2.has_component(component))
@@ -90,12 +77,11 @@ void on_collide(Simulation *sim, Entity &ent1, Entity &ent2) {
     }
 
     if (BOTH(kHealth) && !(ent1.get_team() == ent2.get_team())) {
+        //applied (and deaths requested) at the flush after collide
         if (ent1.health > 0 && ent2.health > 0) {
-            inflict_damage(sim, ent1.id, ent2.id, ent1.damage, DamageType::kContact);
-            inflict_damage(sim, ent2.id, ent1.id, ent2.damage, DamageType::kContact);
+            sim->commands().inflict_damage(ent1.id, ent1.id, ent2.id, ent1.damage, DamageType::kContact);
+            sim->commands().inflict_damage(ent1.id, ent2.id, ent1.id, ent2.damage, DamageType::kContact);
         }
-        if (ent1.health == 0) sim->request_delete(ent1.id);
-        if (ent2.health == 0) sim->request_delete(ent2.id);
     }
 
     if (ent1.has_component(kDrop) && ent2.has_component(kFlower)) 
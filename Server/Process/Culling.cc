@@ -5,11 +5,16 @@
 #include <Shared/Simulation.hh>
 #include <Shared/StaticData.hh>
 
+#include <atomic>
+
 constexpr float CULL_EXTRA_RADIUS = 250;
 
 void tick_culling_behavior(Simulation *sim, Entity &ent) {
     float fov = fclamp(ent.get_fov(), BASE_FOV * 0.3, BASE_FOV);
-    sim->spatial_hash.query(ent.get_camera_x(), ent.get_camera_y(), 960 / fov + CULL_EXTRA_RADIUS, 540 / fov + CULL_EXTRA_RADIUS, [](Simulation *, Entity &ent) {
-        BitMath::unset(ent.flags, EntityFlags::kIsCulled);
-    });
+    static thread_local std::vector<EntityID> in_view;
+    in_view.clear();
+    sim->spatial_hash.query(ent.get_camera_x(), ent.get_camera_y(), 960 / fov + CULL_EXTRA_RADIUS, 540 / fov + CULL_EXTRA_RADIUS, in_view);
+    //runs for several cameras at once, and views overlap
+    for (EntityID const &id : in_view)
+        std::atomic_ref<uint8_t>(sim->get_ent(id).flags).fetch_and(~(1 << EntityFlags::kIsCulled), std::memory_order_relaxed);
 }
@@ -26,8 +26,9 @@ static struct PlayerBuffs _get_petal_passive_buffs(Simulation *sim, Entity &play
     player.set_equip_flags(0);
     player.damage_reflection = 0;
     player.poison_armor = 0;
+    FlowerData const &flower = sim->get_flower_data(player);
     for (uint32_t i = 0; i < player.get_loadout_count(); ++i) {
-        LoadoutSlot const &slot = player.loadout[i];
+        LoadoutSlot const &slot = flower.loadout[i];
         PetalID::T slot_petal_id = slot.get_petal_id();
         struct PetalData const &petal_data = PETAL_DATA[slot_petal_id];
         if (petal_data.attributes.equipment != EquipmentFlags::kNone)
@@ -43,7 +44,7 @@ static struct PlayerBuffs _get_petal_passive_buffs(Simulation *sim, Entity &play
         } else if (slot_petal_id == PetalID::kYinYang) {
             ++buffs.yinyang_count;
         }
-        if (!player.loadout[i].already_spawned) continue;
+        if (!slot.already_spawned) continue;
         if (slot_petal_id == PetalID::kLeaf) 
             buffs.heal += petal_data.attributes.constant_heal / TPS;
         else if (slot_petal_id == PetalID::kYucca && BitMath::at(player.input, InputFlags::kDefending) && !BitMath::at(player.input, InputFlags::kAttacking)) 
@@ -68,8 +69,9 @@ static struct PlayerBuffs _get_petal_passive_buffs(Simulation *sim, Entity &play
 
 static uint32_t _get_petal_rotation_count(Simulation *sim, Entity &player) {
     uint32_t count = 0;
+    FlowerData const &flower = sim->get_flower_data(player);
     for (uint8_t i = 0; i < player.get_loadout_count(); ++i) {
-        LoadoutSlot const &slot = player.loadout[i];
+        LoadoutSlot const &slot = flower.loadout[i];
         struct PetalData const &petal_data = PETAL_DATA[slot.get_petal_id()];
         if (petal_data.attributes.clump_radius > 0)
             ++count;
@@ -114,8 +116,9 @@ void tick_player_behavior(Simulation *sim, Entity &player) {
     }
 
     DEBUG_ONLY(assert(player.get_loadout_count() <= MAX_SLOT_COUNT);)
+    FlowerData &flower = sim->get_flower_data(player);
     for (uint32_t i = 0; i < player.get_loadout_count(); ++i) {
-        LoadoutSlot &slot = player.loadout[i];
+        LoadoutSlot &slot = flower.loadout[i];
         //player.set_loadout_ids(i, slot.id);
         //other way around. loadout_ids should dictate loadout
         if (slot.get_petal_id() != player.get_loadout_ids(i) || player.get_overlevel_timer() >= PETAL_DISABLE_DELAY * TPS)
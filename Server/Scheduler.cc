@@ -0,0 +1,113 @@
+#include <Server/Scheduler.hh>
+
+#include <Helpers/Macros.hh>
+#include <Helpers/Math.hh>
+
+#ifndef SINGLE_THREADED
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//chunks per thread, so uneven chunks still balance out
+static uint32_t const CHUNKS_PER_THREAD = 4;
+
+//workers are detached and still blocked on start_cv at exit, so the pool
+//is never destroyed (destroying a waited-on condition_variable hangs)
+struct WorkerPool {
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable start_cv;
+    std::condition_variable done_cv;
+    std::function<void(uint32_t, uint32_t)> const *job = nullptr;
+    uint32_t job_count = 0;
+    uint32_t job_chunk_size = 1;
+    uint32_t job_generation = 0;
+    uint32_t workers_busy = 0;
+    std::atomic<uint32_t> next_chunk;
+};
+
+static WorkerPool *pool = nullptr;
+static thread_local uint32_t current_thread_index = 0;
+
+static void _run_chunks() {
+    uint32_t const num_chunks = (pool->job_count + pool->job_chunk_size - 1) / pool->job_chunk_size;
+    for (uint32_t chunk = pool->next_chunk++; chunk < num_chunks; chunk = pool->next_chunk++) {
+        uint32_t begin = chunk * pool->job_chunk_size;
+        (*pool->job)(begin, std::min(begin + pool->job_chunk_size, pool->job_count));
+    }
+}
+
+static void _worker_loop(uint32_t index) {
+    current_thread_index = index;
+    select_frand_stream(index);
+    uint32_t seen_generation = 0;
+    while (1) {
+        {
+            std::unique_lock<std::mutex> lock(pool->mutex);
+            pool->start_cv.wait(lock, [&](){ return pool->job_generation != seen_generation; });
+            seen_generation = pool->job_generation;
+        }
+        _run_chunks();
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        if (--pool->workers_busy == 0) pool->done_cv.notify_one();
+    }
+}
+
+void Scheduler::init(uint32_t threads) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    DEBUG_ONLY(assert(pool == nullptr);)
+    pool = new WorkerPool();
+    for (uint32_t i = 1; i < threads; ++i) {
+        pool->workers.emplace_back(_worker_loop, i);
+        pool->workers.back().detach();
+    }
+}
+
+uint32_t Scheduler::thread_count() {
+    return pool == nullptr ? 1 : pool->workers.size() + 1;
+}
+
+uint32_t Scheduler::thread_index() {
+    return current_thread_index;
+}
+
+//below min_chunk_size items per thread, splitting costs more than it saves
+void Scheduler::parallel_for(uint32_t count, std::function<void(uint32_t, uint32_t)> const &cb, uint32_t min_chunk_size) {
+    uint32_t const threads = thread_count();
+    if (threads == 1 || count < 2 * min_chunk_size) {
+        if (count > 0) cb(0, count);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->job = &cb;
+        pool->job_count = count;
+        pool->job_chunk_size = std::max(min_chunk_size, (count + threads * CHUNKS_PER_THREAD - 1) / (threads * CHUNKS_PER_THREAD));
+        pool->next_chunk = 0;
+        pool->workers_busy = pool->workers.size();
+        ++pool->job_generation;
+    }
+    pool->start_cv.notify_all();
+    _run_chunks();
+    std::unique_lock<std::mutex> lock(pool->mutex);
+    pool->done_cv.wait(lock, [](){ return pool->workers_busy == 0; });
+    pool->job = nullptr;
+}
+#else
+void Scheduler::init(uint32_t) {}
+
+uint32_t Scheduler::thread_count() {
+    return 1;
+}
+
+uint32_t Scheduler::thread_index() {
+    return 0;
+}
+
+void Scheduler::parallel_for(uint32_t count, std::function<void(uint32_t, uint32_t)> const &cb, uint32_t) {
+    if (count > 0) cb(0, count);
+}
+#endif
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+//worker pool for tick work that can be split across threads
+//SINGLE_THREADED (always set for the wasm server) runs everything on the calling thread
+namespace Scheduler {
+    //total threads including the caller; 0 uses the hardware concurrency
+    //call before Simulation::set_capacity, which sizes per-thread storage from thread_count()
+    void init(uint32_t);
+    uint32_t thread_count();
+    //0 for the thread that called init, [1, thread_count()) for the workers
+    //each thread draws frand() from the stream numbered by its index
+    uint32_t thread_index();
+    //calls cb(begin, end) over disjoint chunks covering [0, count) and returns once all are done
+    //chunks may run in any order and on any thread, so cb must not depend on either
+    //chunks hold at least min_chunk_size items (the default suits cheap per-entity work)
+    void parallel_for(uint32_t, std::function<void(uint32_t, uint32_t)> const &, uint32_t = 64);
+}
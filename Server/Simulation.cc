@@ -30,8 +30,194 @@ static void calculate_leaderboard(Simulation *sim) {
     }
 }
 
+CommandBuffer &Simulation::commands() {
+    DEBUG_ONLY(assert(Scheduler::thread_index() < command_buffers.size());)
+    return command_buffers[Scheduler::thread_index()];
+}
+
+void Simulation::_next_command_phase() {
+    for (CommandBuffer &buffer : command_buffers)
+        ++buffer.phase;
+}
+
+//above the Scheduler threads' own streams, which are numbered by thread index
+uint64_t Simulation::_frand_stream(uint32_t pass, EntityID::id_type slot) {
+    return ((uint64_t) pass << 32) | slot;
+}
+
+static void _apply_command(Simulation *sim, Command const &command) {
+    switch (command.kind) {
+        case Command::kSpawnMob: {
+            Entity &mob = alloc_mob(sim, command.mob_id, command.x, command.y, command.team);
+            mob.set_parent(command.subject);
+            mob.target = command.other;
+            if (command.despawn_ticks > 0) entity_set_despawn_tick(mob, command.despawn_ticks);
+            break;
+        }
+        case Command::kSpawnWeb:
+            if (sim->ent_exists(command.subject)) alloc_web(sim, command.radius, sim->get_ent(command.subject));
+            break;
+        case Command::kSpawnMissile: {
+            if (!sim->ent_exists(command.subject)) break;
+            Entity &missile = alloc_petal(sim, PetalID::kMissile, sim->get_ent(command.subject));
+            missile.damage = 10;
+            missile.health = missile.max_health = 10;
+            entity_set_despawn_tick(missile, 3 * TPS);
+            missile.set_angle(command.angle);
+            missile.acceleration.unit_normal(command.angle).set_magnitude(40 * PLAYER_ACCELERATION);
+            break;
+        }
+        case Command::kDelete:
+            if (sim->ent_exists(command.subject)) sim->request_delete(command.subject);
+            break;
+        case Command::kDamage:
+            inflict_damage(sim, command.other, command.subject, command.amount, command.damage_type);
+            //contact kills land here rather than at the next health tick, as they did
+            //when collision applied damage itself
+            if (command.damage_type == DamageType::kContact && sim->ent_alive(command.subject)
+                && sim->get_ent(command.subject).health == 0)
+                sim->request_delete(command.subject);
+            break;
+        case Command::kHeal:
+            if (sim->ent_alive(command.subject)) inflict_heal(sim, sim->get_ent(command.subject), command.amount);
+            break;
+        case Command::kSetTarget:
+            if (sim->ent_alive(command.subject)) sim->get_ent(command.subject).target = command.other;
+            break;
+        case Command::kPickupDrop: {
+            //the first pickup applied takes the drop, later ones find it deleted
+            if (!sim->ent_alive(command.subject) || !sim->ent_alive(command.other)) break;
+            Entity &player = sim->get_ent(command.subject);
+            Entity &drop = sim->get_ent(command.other);
+            for (uint32_t i = 0; i < player.get_loadout_count() + MAX_SLOT_COUNT; ++i) {
+                if (player.get_loadout_ids(i) != PetalID::kNone) continue;
+                player.set_loadout_ids(i, drop.get_drop_id());
+                drop.set_x(player.get_x());
+                drop.set_y(player.get_y());
+                BitMath::unset(drop.flags, EntityFlags::kIsDespawning);
+                sim->request_delete(drop.id);
+                //peaceful transfer, no petal tracking needed
+                break;
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+//applying a command can issue more (eg. damage spawning ant hole waves), so this
+//repeats until every buffer is empty
+void Simulation::flush_commands() {
+    while (1) {
+        merged_commands.clear();
+        for (CommandBuffer &buffer : command_buffers) {
+            merged_commands.insert(merged_commands.end(), buffer.commands.begin(), buffer.commands.end());
+            buffer.clear();
+        }
+        if (merged_commands.empty()) return;
+        std::sort(merged_commands.begin(), merged_commands.end(), [](Command const &a, Command const &b) {
+            if (a.phase != b.phase) return a.phase < b.phase;
+            if (a.issuer != b.issuer) return a.issuer < b.issuer;
+            return a.seq < b.seq;
+        });
+        for (Command const &command : merged_commands)
+            _apply_command(this, command);
+    }
+}
+
+uint64_t Simulation::_system_word(uint32_t with, uint32_t word) const {
+    uint64_t bits = tick_start_tracker[word];
+    for (uint32_t comps = with; comps != 0; comps &= comps - 1)
+        bits &= component_tracker[BitMath::ctz(comps)][word];
+    return bits;
+}
+
+//the same visiting order and delete handling as for_each_matching
+void Simulation::_run_serial(System const &system) {
+    for (uint32_t word = 0; word < tick_start_tracker.size(); ++word) {
+        uint64_t bits = _system_word(system.with, word);
+        while (bits != 0) {
+            uint32_t bit = BitMath::ctz(bits);
+            Entity &ent = entities[word * 64 + bit];
+            if (!ent.pending_delete)
+                system.tick(this, ent);
+            bits = _system_word(system.with, word) & ~((2ull << bit) - 1);
+        }
+    }
+}
+
+//each system of the stage keeps its own command phase and frand streams, so
+//the stage gives the same result as running its systems one after another
+void Simulation::_run_stage(std::span<System const> stage) {
+    stage_items.clear();
+    for (uint32_t s = 0; s < stage.size(); ++s) {
+        for (uint32_t word = 0; word < tick_start_tracker.size(); ++word) {
+            for (uint64_t bits = _system_word(stage[s].with, word); bits != 0; bits &= bits - 1) {
+                EntityID::id_type slot = word * 64 + BitMath::ctz(bits);
+                if (!entities[slot].pending_delete) stage_items.push_back({ s, slot });
+            }
+        }
+    }
+    uint32_t const first_phase = command_buffers[0].phase + 1;
+    uint32_t const first_pass = parallel_pass + 1;
+    parallel_pass += stage.size();
+    Scheduler::parallel_for(stage_items.size(), [&](uint32_t begin, uint32_t end) {
+        CommandBuffer &buffer = commands();
+        for (uint32_t i = begin; i < end; ++i) {
+            auto const [s, slot] = stage_items[i];
+            buffer.phase = first_phase + s;
+            FrandStream stream(_frand_stream(first_pass + s, slot));
+            stage[s].tick(this, entities[slot]);
+        }
+    });
+    for (CommandBuffer &buffer : command_buffers)
+        buffer.phase = first_phase + stage.size();
+}
+
+void Simulation::run_systems(std::span<System const> systems) {
+    for (uint32_t begin = 0; begin < systems.size();) {
+        uint32_t end = begin + 1;
+        if (!systems[begin].parallel()) {
+            _run_serial(systems[begin]);
+        } else {
+            for (; end < systems.size() && systems[end].parallel(); ++end) {
+                bool conflict = false;
+                for (uint32_t i = begin; i < end; ++i)
+                    conflict = conflict || systems[end].conflicts(systems[i]);
+                if (conflict) break;
+            }
+            _run_stage(systems.subspan(begin, end - begin));
+        }
+        flush_commands();
+        begin = end;
+    }
+}
+
+//in tick order, with what each system touches (see System). the ai only writes its own
+//mob and issues its spawns and deletes as commands, so it runs in parallel. the
+//sandstorm passes read other mobs' acceleration, so they run serially around it
+static System const PRE_COLLISION_SYSTEMS[] = {
+    { tick_sandstorm_snapshot, component_mask(kMob), Access::kMotion | Access::kLifecycle, Access::kMotion },
+    { tick_ai_behavior, component_mask(kMob), Access::kPosition | Access::kLifecycle, Access::kMotion | Access::kBehavior },
+    { tick_sandstorm_follow, component_mask(kMob), Access::kMotion, Access::kMotion },
+    { tick_petal_behavior, component_mask(kPetal), 0, Access::kExclusive },
+    { tick_health_behavior, component_mask(kHealth), 0, Access::kExclusive }
+};
+
+//score does not depend on the systems it used to run after, and sits next to motion
+//so the two share a stage. segments follow the segment ahead of them, so they run in order
+static System const POST_COLLISION_SYSTEMS[] = {
+    { tick_entity_motion, component_mask(kPhysics), 0, Access::kPosition | Access::kMotion },
+    { tick_score_behavior, component_mask(kScore), 0, Access::kScore },
+    { tick_segment_behavior, component_mask(kSegmented), Access::kPosition | Access::kLifecycle | Access::kBehavior,
+        Access::kPosition | Access::kMotion | Access::kBehavior },
+    { tick_camera_behavior, component_mask(kCamera), 0, Access::kExclusive }
+};
+
 void Simulation::on_tick() {
-    spatial_hash.refresh(ARENA_WIDTH, ARENA_HEIGHT);
+    spatial_hash.begin_tick();
+    target_index.begin_tick();
     if (frand() < 1.0f / TPS) {
         for (uint32_t i = 0; i < 10; ++i) {
             Vector v;
@@ -42,20 +228,22 @@ void Simulation::on_tick() {
     for_each_entity([](Simulation *sim, Entity &ent) {
         if (ent.has_component(kPhysics))
             sim->spatial_hash.insert(ent);
+        if (ent.has_component(kMob) || ent.has_component(kFlower))
+            sim->target_index.insert(ent);
         if (BitMath::at(ent.flags, EntityFlags::kHasCulling))
             BitMath::set(ent.flags, EntityFlags::kIsCulled);
     });
-    for_each<kCamera>(tick_culling_behavior);
+    //culling only reads the grid once it is built, and only clears kIsCulled bits
+    spatial_hash.build();
+    for_each_parallel<kCamera>(tick_culling_behavior);
     for_each<kFlower>(tick_player_behavior);
-    for_each<kMob>(tick_ai_behavior);
-    for_each<kPetal>(tick_petal_behavior);
-    for_each<kHealth>(tick_health_behavior);
+    target_index.build();
+    acquire_targets(this);
+    run_systems(PRE_COLLISION_SYSTEMS);
     spatial_hash.collide(on_collide);
+    flush_commands();
     tick_curse_behavior(this);
-    for_each<kPhysics>(tick_entity_motion);
-    for_each<kSegmented>(tick_segment_behavior);
-    for_each<kCamera>(tick_camera_behavior);
-    for_each<kScore>(tick_score_behavior);
+    run_systems(POST_COLLISION_SYSTEMS);
     for_each_entity(entity_clear_references);
     calculate_leaderboard(this);
 }
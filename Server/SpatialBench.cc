@@ -0,0 +1,188 @@
+#include <Server/Spawn.hh>
+
+#include <Shared/Map.hh>
+#include <Shared/Simulation.hh>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+//times the SpatialHash built into this binary (gardn-spatial-bench target)
+//usage: gardn-spatial-bench [entities, 0 for a full arena] [rounds] [percent moving] [percent large]
+//entities are scattered uniformly over the arena with radii of 10-50 (100-800 for the
+//large ones, which the uniform grids do not support), or spawned by
+//the map's zones until they are full, plus piles of drops and fighting players.
+//the moving ones (mobs that are not stationary) take a step of up to 10 units each
+//round. spatial-bench-compare builds and runs it against every implementation.
+//nearest-enemy searches are timed both as a box query plus a min and with nearest()
+
+static uint32_t const QUERIES_PER_ROUND = 256;
+//the largest mob aggro radius
+static float const NEAREST_RADIUS = 750;
+//enough room for every zone to fill up
+static uint32_t const ARENA_ENTITY_CAP = 32768;
+static uint32_t const ARENA_DROP_PILES = 100;
+static uint32_t const ARENA_FIGHTS = 20;
+
+typedef std::chrono::duration<double, std::milli> ms_t;
+
+int main(int argc, char **argv) {
+    uint32_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 8192;
+    uint32_t rounds = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 100;
+    uint32_t percent_moving = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 100;
+    uint32_t percent_large = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 0;
+    seed_frand(0);
+    Simulation *sim = new Simulation();
+    std::vector<Entity *> ents;
+    std::vector<Entity *> movable;
+    if (count == 0) {
+        sim->set_capacity(ARENA_ENTITY_CAP);
+        for (uint32_t i = 0; i < ARENA_ENTITY_CAP / 2; ++i)
+            Map::spawn_random_mob(sim, frand() * ARENA_WIDTH, frand() * ARENA_HEIGHT);
+        //kills leave piles of drops on one spot
+        for (uint32_t i = 0; i < ARENA_DROP_PILES; ++i) {
+            float x = frand() * ARENA_WIDTH, y = frand() * ARENA_HEIGHT;
+            for (uint32_t j = 0; j < 3; ++j) {
+                Entity &drop = alloc_drop(sim, PetalID::kBasic);
+                drop.set_x(x);
+                drop.set_y(y);
+            }
+        }
+        //pairs of flowers fighting, each with its petals clumped up between them
+        auto add_flower = [&](float x, float y, float facing) {
+            Entity &flower = sim->alloc_ent();
+            sim->add_component(flower, kPhysics);
+            sim->add_component(flower, kRelations);
+            sim->add_component(flower, kFlower);
+            flower.set_team(flower.id);
+            flower.set_x(x);
+            flower.set_y(y);
+            flower.set_radius(25);
+            for (uint32_t j = 0; j < MAX_SLOT_COUNT; ++j) {
+                Entity &petal = sim->alloc_ent();
+                sim->add_component(petal, kPhysics);
+                sim->add_component(petal, kRelations);
+                sim->add_component(petal, kPetal);
+                petal.set_team(flower.id);
+                petal.set_x(x + facing * 50 + 15 * cosf(j * 2 * M_PI / MAX_SLOT_COUNT));
+                petal.set_y(y + 15 * sinf(j * 2 * M_PI / MAX_SLOT_COUNT));
+                petal.set_radius(10);
+            }
+        };
+        for (uint32_t i = 0; i < ARENA_FIGHTS; ++i) {
+            float x = frand() * (ARENA_WIDTH - 300) + 100;
+            float y = frand() * (ARENA_HEIGHT - 200) + 100;
+            add_flower(x, y, 1);
+            add_flower(x + 100, y, -1);
+        }
+        //nothing has been deleted, so every hash is still 0
+        for (uint32_t i = 1; i < ARENA_ENTITY_CAP; ++i) {
+            if (!sim->ent_exists(EntityID(i, 0))) continue;
+            Entity &ent = sim->get_ent(EntityID(i, 0));
+            ents.push_back(&ent);
+            if (ent.has_component(kMob) && !MOB_DATA[ent.get_mob_id()].attributes.stationary) movable.push_back(&ent);
+        }
+    } else {
+        sim->set_capacity(count + 1);
+        for (uint32_t i = 0; i < count; ++i) {
+            Entity &ent = sim->alloc_ent();
+            ents.push_back(&ent);
+            movable.push_back(&ent);
+            sim->add_component(ent, kPhysics);
+            //on a team of their own, so every overlapping pair counts
+            sim->add_component(ent, kRelations);
+            ent.set_team(ent.id);
+            ent.set_x(frand() * ARENA_WIDTH);
+            ent.set_y(frand() * ARENA_HEIGHT);
+            if (i < count * percent_large / 100)
+                ent.set_radius(100 + frand() * 700);
+            else
+                ent.set_radius(10 + frand() * 40);
+        }
+    }
+    uint32_t const moving = movable.size() * percent_moving / 100;
+
+    ms_t insert_time(0), collide_time(0), query_time(0), scan_time(0), nearest_time(0);
+    uint64_t pairs = 0, overlaps = 0, results = 0, found = 0, mismatches = 0;
+    std::vector<EntityID> buffer;
+    sim->spatial_hash.refresh(ARENA_WIDTH, ARENA_HEIGHT);
+    for (uint32_t round = 0; round < rounds; ++round) {
+        for (uint32_t i = 0; i < moving; ++i) {
+            Entity &ent = *movable[i];
+            ent.set_x(fclamp(ent.get_x() + frand() * 20 - 10, 0, ARENA_WIDTH));
+            ent.set_y(fclamp(ent.get_y() + frand() * 20 - 10, 0, ARENA_HEIGHT));
+        }
+        auto start = std::chrono::steady_clock::now();
+        sim->spatial_hash.begin_tick();
+        for (Entity *ent : ents)
+            sim->spatial_hash.insert(*ent);
+        auto inserted = std::chrono::steady_clock::now();
+        sim->spatial_hash.collide([&](Simulation *, Entity &a, Entity &b) {
+            ++pairs;
+            float dx = a.get_x() - b.get_x(), dy = a.get_y() - b.get_y(), r = a.get_radius() + b.get_radius();
+            if (dx * dx + dy * dy <= r * r) ++overlaps;
+        });
+        auto collided = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < QUERIES_PER_ROUND; ++i) {
+            //about the size of a camera view
+            buffer.clear();
+            sim->spatial_hash.query(frand() * ARENA_WIDTH, frand() * ARENA_HEIGHT, 1000, 600, buffer);
+            results += buffer.size();
+        }
+        auto queried = std::chrono::steady_clock::now();
+        std::vector<Entity *> seekers;
+        for (uint32_t i = 0; i < QUERIES_PER_ROUND; ++i)
+            seekers.push_back(ents[frand() * ents.size()]);
+        auto is_enemy = [](Entity const &seeker, Entity const &ent) {
+            return !(ent.get_team() == seeker.get_team()) && !ent.has_component(kDrop);
+        };
+        std::vector<float> scan_dist;
+        auto scan_start = std::chrono::steady_clock::now();
+        for (Entity *seeker : seekers) {
+            buffer.clear();
+            sim->spatial_hash.query(seeker->get_x(), seeker->get_y(), NEAREST_RADIUS, NEAREST_RADIUS, buffer);
+            float min_dist = NEAREST_RADIUS;
+            for (EntityID const &id : buffer) {
+                Entity &ent = sim->get_ent(id);
+                if (!is_enemy(*seeker, ent)) continue;
+                min_dist = std::min(min_dist, Vector(ent.get_x() - seeker->get_x(), ent.get_y() - seeker->get_y()).magnitude());
+            }
+            scan_dist.push_back(min_dist);
+        }
+        auto scanned = std::chrono::steady_clock::now();
+        std::vector<EntityID> nearest;
+        for (Entity *seeker : seekers)
+            nearest.push_back(sim->spatial_hash.nearest(seeker->get_x(), seeker->get_y(), NEAREST_RADIUS, [&](Entity &ent) {
+                return is_enemy(*seeker, ent);
+            }));
+        auto searched = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < seekers.size(); ++i) {
+            float dist = NEAREST_RADIUS;
+            if (!nearest[i].null()) {
+                Entity &ent = sim->get_ent(nearest[i]);
+                dist = Vector(ent.get_x() - seekers[i]->get_x(), ent.get_y() - seekers[i]->get_y()).magnitude();
+                ++found;
+            }
+            if (dist != scan_dist[i]) ++mismatches;
+        }
+        insert_time += inserted - start;
+        collide_time += collided - inserted;
+        query_time += queried - collided;
+        scan_time += scanned - scan_start;
+        nearest_time += searched - scanned;
+    }
+    std::cout << "Entities: " << ents.size() << '\n';
+    std::cout << "Pairs/round: " << pairs / rounds << '\n';
+    std::cout << "Overlaps/round: " << overlaps / rounds << '\n';
+    std::cout << "Query results/round: " << results / rounds << '\n';
+    std::cout << "ms/round insert: " << insert_time.count() / rounds << '\n';
+    std::cout << "ms/round collide: " << collide_time.count() / rounds << '\n';
+    std::cout << "ms/round " << QUERIES_PER_ROUND << " queries: " << query_time.count() / rounds << '\n';
+    std::cout << "Nearest found/round: " << found / rounds << ", mismatches: " << mismatches << '\n';
+    std::cout << "ms/round " << QUERIES_PER_ROUND << " nearest, box scan: " << scan_time.count() / rounds << '\n';
+    std::cout << "ms/round " << QUERIES_PER_ROUND << " nearest, rings: " << nearest_time.count() / rounds << '\n';
+    return mismatches > 0;
+}
@@ -3,6 +3,7 @@
 #include <Shared/Entity.hh>
 #include <Shared/StaticData.hh>
 
+#include <algorithm>
 #include <cstdint>
 #include <functional>
 #include <vector>
@@ -14,15 +15,282 @@ static const uint32_t GRID_SIZE = 100 * 2;
 static const uint32_t MAX_GRID_X = div_round_up(ARENA_WIDTH, GRID_SIZE);
 static const uint32_t MAX_GRID_Y = div_round_up(ARENA_HEIGHT, GRID_SIZE);
 
+//the part of on_collide's rules that only depends on team, components and flags
+//precomputed per entity so the grid can drop pairs on_collide would ignore
+struct CollisionFilter {
+    enum : uint8_t {
+        kIsMob = 1 << 0,
+        kIsFlower = 1 << 1,
+        kIsPetal = 1 << 2,
+        kIsDrop = 1 << 3,
+        kIsWeb = 1 << 4,
+        kNoFriendly = 1 << 5
+    };
+    EntityID team;
+    uint8_t kind;
+    CollisionFilter() = default;
+    CollisionFilter(Entity const &);
+};
+
+inline CollisionFilter::CollisionFilter(Entity const &ent) : team(ent.get_team()), kind(0) {
+    if (ent.has_component(kMob)) kind |= kIsMob;
+    if (ent.has_component(kFlower)) kind |= kIsFlower;
+    if (ent.has_component(kPetal)) kind |= kIsPetal;
+    if (ent.has_component(kDrop)) kind |= kIsDrop;
+    if (ent.has_component(kWeb)) kind |= kIsWeb;
+    if (BitMath::at(ent.flags, EntityFlags::kNoFriendlyCollision)) kind |= kNoFriendly;
+}
+
+//same team: only mobs bump into each other (unless flagged)
+//otherwise everything interacts, except that drops can only be picked up
+//by flowers, and webs only slow what is not a petal, drop or web
+inline bool collision_filters_interact(CollisionFilter const &a, CollisionFilter const &b) {
+    if (a.team == b.team)
+        return !((a.kind | b.kind) & CollisionFilter::kNoFriendly) && (a.kind & b.kind & CollisionFilter::kIsMob);
+    if ((a.kind | b.kind) & CollisionFilter::kIsDrop)
+        return ((a.kind | b.kind) & CollisionFilter::kIsFlower) && !((a.kind & b.kind) & CollisionFilter::kIsDrop);
+    uint8_t const inert = CollisionFilter::kIsPetal | CollisionFilter::kIsDrop | CollisionFilter::kIsWeb;
+    if ((a.kind & CollisionFilter::kIsWeb) && (b.kind & inert)) return false;
+    if ((b.kind & CollisionFilter::kIsWeb) && (a.kind & inert)) return false;
+    return true;
+}
+
+//calls fn(x, y) for every cell of a grid_x by grid_y grid that is exactly ring cells
+//(chebyshev distance) from cell (cx, cy)
+template<typename F>
+void for_each_ring_cell(uint32_t cx, uint32_t cy, uint32_t ring, uint32_t grid_x, uint32_t grid_y, F fn) {
+    int32_t const sx = (int32_t) cx - (int32_t) ring, ex = cx + ring;
+    int32_t const sy = (int32_t) cy - (int32_t) ring, ey = cy + ring;
+    for (int32_t x = std::max(sx, 0); x <= std::min(ex, (int32_t) grid_x - 1); ++x) {
+        if (x == sx || x == ex) {
+            for (int32_t y = std::max(sy, 0); y <= std::min(ey, (int32_t) grid_y - 1); ++y)
+                fn(x, y);
+            continue;
+        }
+        if (sy >= 0) fn(x, sy);
+        if (ey < (int32_t) grid_y) fn(x, ey);
+    }
+}
+
+//calls fn(cx, cy, ring) for ring = 0, 1, ... around the cell (cx, cy) of a grid_x by grid_y grid
+//of cell_size cells that holds (x, y), and stops at the first ring that cannot hold anything
+//closer than best_dist, which fn lowers as it finds closer things
+template<typename F>
+void for_each_ring(float x, float y, uint32_t cell_size, uint32_t grid_x, uint32_t grid_y, float const &best_dist, F fn) {
+    float const clamped_x = fclamp(x, 0, grid_x * cell_size - 1);
+    float const clamped_y = fclamp(y, 0, grid_y * cell_size - 1);
+    uint32_t const cx = clamped_x / cell_size;
+    uint32_t const cy = clamped_y / cell_size;
+    //(x, y) is at least edge away from the sides of cell (cx, cy), so every
+    //cell of ring r > 0 is at least (r - 1) * cell_size + edge away
+    float const fx = clamped_x - cx * cell_size;
+    float const fy = clamped_y - cy * cell_size;
+    float const edge = std::min(std::min(fx, cell_size - fx), std::min(fy, cell_size - fy));
+    uint32_t const max_ring = std::max(grid_x, grid_y);
+    for (uint32_t ring = 0; ring <= max_ring; ++ring) {
+        if (ring > 0 && (ring - 1) * cell_size + edge >= best_dist) break;
+        fn(cx, cy, ring);
+    }
+}
+
+//an entity found by SpatialHash::_gather_ring, with its position
+struct SpatialHashCandidate {
+    EntityID id;
+    float x;
+    float y;
+};
+
+#ifdef GENERAL_SPATIAL_HASH
+//an entity's entry in every cell it covers, with the first of those cells
+struct SpatialHashCellRef {
+    EntityID id;
+    uint16_t sx;
+    uint16_t sy;
+};
+#else
+//an entity as of its last insert() call, stored contiguously by cell
+struct SpatialHashEntry {
+    float x;
+    float y;
+    float radius;
+    EntityID id;
+    CollisionFilter filter;
+};
+#endif
+#if !defined(GENERAL_SPATIAL_HASH) && !defined(INCREMENTAL_SPATIAL_HASH)
+//x, y and radius of a sorted layer's entries, in the same order, for the Narrowphase kernels
+struct SpatialHashLanes {
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> radius;
+};
+#endif
+#if defined(HIERARCHICAL_SPATIAL_HASH) && !defined(GENERAL_SPATIAL_HASH) && !defined(INCREMENTAL_SPATIAL_HASH)
+//one level of the hierarchical grid, laid out like the uniform grid's dynamic layer
+struct SpatialHashLevel {
+    uint32_t cell_size;
+    uint32_t grid_x;
+    uint32_t grid_y;
+    //the largest radius inserted since begin_tick(), how far an entity can reach out of its cell
+    float max_radius;
+    std::vector<SpatialHashEntry> pending;
+    std::vector<SpatialHashEntry> entries;
+    SpatialHashLanes lanes;
+    std::vector<uint32_t> cell_start;
+};
+#endif
+#if defined(SPARSE_SPATIAL_HASH) && !defined(GENERAL_SPATIAL_HASH) && !defined(INCREMENTAL_SPATIAL_HASH) && !defined(HIERARCHICAL_SPATIAL_HASH)
+//an open-addressing table slot: an occupied cell's coordinates and its index
+struct SpatialHashTableSlot {
+    uint32_t key;
+    uint32_t cell;
+};
+#endif
+#ifdef INCREMENTAL_SPATIAL_HASH
+//a cell's block of SpatialHash::entries
+struct SpatialHashCell {
+    uint32_t begin;
+    uint32_t count;
+    uint32_t capacity;
+};
+#endif
+
 class SpatialHash {
     Simulation *simulation;
-    std::vector<EntityID> cells[MAX_GRID_X][MAX_GRID_Y];
+#if defined(GENERAL_SPATIAL_HASH)
+    std::vector<SpatialHashCellRef> cells[MAX_GRID_X][MAX_GRID_Y];
+#elif defined(INCREMENTAL_SPATIAL_HASH)
+    //entities stay in the grid between ticks: insert() skips an entity that is not
+    //spatial_dirty, updates it in place, and only moves it when its cell changes. each
+    //cell owns a block of entries with some slack; a full block is moved to the end of
+    //entries, and begin_tick() compacts once the abandoned blocks outweigh the live ones
+    //cell c = x * MAX_GRID_Y + y
+    std::vector<SpatialHashEntry> entries;
+    std::vector<SpatialHashCell> cells;
+    //per slot: its cell (or NO_CELL) and its index in entries
+    std::vector<uint32_t> slot_cell;
+    std::vector<uint32_t> slot_index;
+    uint32_t abandoned;
+    void _add(uint32_t, SpatialHashEntry const &);
+    void _remove(EntityID::id_type);
+    void _compact();
+#elif defined(HIERARCHICAL_SPATIAL_HASH)
+    //level l has cells of GRID_SIZE << l, and the last level is a single cell covering the arena.
+    //an entity goes by its center into the first level whose cells are at least twice its
+    //radius, so on its own level it can only overlap the 3x3 block around its cell. pairs
+    //across levels are found from the coarser entity's side. rebuilt every tick, and sorted
+    //by build() like the uniform grid
+    std::vector<SpatialHashLevel> levels;
+    //levels with anything in them, finest first
+    std::vector<uint32_t> occupied;
+    std::vector<uint32_t> hits;
+    uint8_t sorted;
+#elif defined(SPARSE_SPATIAL_HASH)
+    //covers whatever refresh() is given, even past ARENA_WIDTH and ARENA_HEIGHT
+    //only occupied cells exist: cell c has coordinates cell_keys[c] (x << 16 | y, ascending) and
+    //holds entries[cell_start[c], cell_start[c + 1]). table maps coordinates to c, so memory and
+    //collide() scale with the number of occupied cells instead of the arena's area.
+    //insert() appends to pending, and build() rebuilds the rest
+    std::vector<SpatialHashEntry> pending;
+    std::vector<uint32_t> pending_cell;
+    std::vector<SpatialHashEntry> entries;
+    SpatialHashLanes lanes;
+    std::vector<uint32_t> cell_keys;
+    std::vector<uint32_t> cell_start;
+    std::vector<SpatialHashTableSlot> table;
+    //scratch for renumbering the cells in build()
+    std::vector<uint64_t> cell_order;
+    std::vector<uint32_t> renumber;
+    std::vector<uint32_t> hits;
+    uint8_t sorted;
+    uint32_t _find(uint32_t) const;
+    //x, sy, ey, begin, end: the entries of the occupied cells among (x, sy) to (x, ey)
+    void _column(uint32_t, uint32_t, uint32_t, uint32_t &, uint32_t &) const;
+#else
+    //insert() appends to pending, and build() counting-sorts pending by cell into entries
+    //cell c holds entries[cell_start[c], cell_start[c + 1]), c = x * MAX_GRID_Y + y
+    std::vector<SpatialHashEntry> pending;
+    std::vector<SpatialHashEntry> entries;
+    SpatialHashLanes lanes;
+    std::vector<uint32_t> cell_start;
+    uint8_t sorted;
+    //static layer: stationary mobs, drops and webs. kept across ticks in static_list
+    //(static_list_index maps slot -> entry) and only re-sorted into static_entries
+    //when one is added, removed or moves. static entries are never paired with each other
+    std::vector<SpatialHashEntry> static_list;
+    std::vector<uint32_t> static_list_index;
+    std::vector<SpatialHashEntry> static_entries;
+    SpatialHashLanes static_lanes;
+    std::vector<uint32_t> static_cell_start;
+    uint8_t static_sorted;
+    //indices written by the Narrowphase kernel
+    std::vector<uint32_t> hits;
+    void _unlist_static(EntityID::id_type);
+#endif
+    //in cells
     uint32_t width;
     uint32_t height;
+    Entity &_entity(EntityID const &);
+    //appends everything in the cells ring cells away from cell (cx, cy); an entity
+    //that covers several of them (SpatialHashCanonical) may be appended more than once
+    void _gather_ring(uint32_t, uint32_t, uint32_t, std::vector<SpatialHashCandidate> &);
 public:
     SpatialHash(Simulation *);
+    //empties the grid
     void refresh(uint32_t, uint32_t);
-    void insert(Entity const &);
+    //called at the start of every tick, before the entities are (re)inserted
+    void begin_tick();
+    //every kPhysics entity is inserted once per tick. clears Entity::spatial_dirty, which
+    //set_x, set_y, set_radius and set_team raise
+    void insert(Entity &);
+    //called when an entity is deleted
+    void remove(Entity const &);
+    //sorts what was inserted or removed since the last build, if the grid needs it. queries
+    //only read the grid, so this has to run (on one thread) between any insert() or remove()
+    //and the next query() or nearest()
+    void build();
+    //builds the grid first
     void collide(std::function<void(Simulation *, Entity &, Entity &)>);
-    void query(float, float, float, float, std::function<void(Simulation *, Entity &)>);
-};
\ No newline at end of file
+    //appends every entity whose bounding box touches the box (x - w, y - h) to (x + w, y + h), once each
+    //read only, so it can be made from several threads at once
+    void query(float, float, float, float, std::vector<EntityID> &);
+    //same, but only appends the entities pred(Entity &) returns true for
+    template<typename Pred>
+    void query(float, float, float, float, std::vector<EntityID> &, Pred);
+    //the closest entity (center to center) that is less than max_dist from (x, y) and
+    //that pred(Entity &) returns true for, or NULL_ENTITY. searches out one ring of cells
+    //at a time, and stops at the first ring that cannot hold anything closer.
+    //pred only runs on entities closer than the best so far
+    template<typename Pred>
+    EntityID nearest(float, float, float, Pred);
+};
+
+template<typename Pred>
+void SpatialHash::query(float x, float y, float w, float h, std::vector<EntityID> &out, Pred pred) {
+    uint32_t const begin = out.size();
+    query(x, y, w, h, out);
+    out.erase(std::remove_if(out.begin() + begin, out.end(), [&](EntityID const &id) {
+        return !pred(_entity(id));
+    }), out.end());
+}
+
+template<typename Pred>
+EntityID SpatialHash::nearest(float x, float y, float max_dist, Pred pred) {
+    static thread_local std::vector<SpatialHashCandidate> candidates;
+    EntityID best;
+    float best_dist = max_dist;
+    //over the grid refresh() was given, which the sparse hash does not bound by the arena constants
+    for_each_ring(x, y, GRID_SIZE, width, height, best_dist, [&](uint32_t cx, uint32_t cy, uint32_t ring) {
+        candidates.clear();
+        _gather_ring(cx, cy, ring, candidates);
+        for (SpatialHashCandidate const &candidate : candidates) {
+            float dist = Vector(candidate.x - x, candidate.y - y).magnitude();
+            if (dist >= best_dist) continue;
+            Entity &ent = _entity(candidate.id);
+            if (!pred(ent)) continue;
+            best_dist = dist;
+            best = candidate.id;
+        }
+    });
+    return best;
+}
\ No newline at end of file
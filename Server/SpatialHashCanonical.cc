@@ -3,12 +3,7 @@
 #include <Shared/Simulation.hh>
 #include <Shared/Entity.hh>
 
-#include <unordered_set>
-
-static uint32_t _hash_two(EntityID const a, EntityID const b) {
-    if (a.id > b.id) return (a.id << 16) + b.id;
-    else return (b.id << 16) + a.id;
-}
+#include <algorithm>
 
 SpatialHash::SpatialHash(Simulation *sim) : simulation(sim), width(1), height(1) {}
 
@@ -21,53 +16,79 @@ void SpatialHash::refresh(uint32_t _width, uint32_t _height) {
             cells[x][y].clear();
 }
 
-void SpatialHash::insert(Entity const &ent) {
+//rebuilt from scratch every tick
+void SpatialHash::begin_tick() {
+    for (uint32_t x = 0; x < MAX_GRID_X; ++x)
+        for (uint32_t y = 0; y < MAX_GRID_Y; ++y)
+            cells[x][y].clear();
+}
+
+void SpatialHash::insert(Entity &ent) {
     DEBUG_ONLY(assert(ent.has_component(kPhysics));)
     uint32_t sx = fclamp(ent.get_x() - ent.get_radius(), 0, ARENA_WIDTH - 1) / GRID_SIZE;
     uint32_t sy = fclamp(ent.get_y() - ent.get_radius(), 0, ARENA_HEIGHT - 1) / GRID_SIZE;
     uint32_t ex = fclamp(ent.get_x() + ent.get_radius(), 0, ARENA_WIDTH - 1) / GRID_SIZE;
     uint32_t ey = fclamp(ent.get_y() + ent.get_radius(), 0, ARENA_HEIGHT - 1) / GRID_SIZE;
+    SpatialHashCellRef const ref = { ent.id, (uint16_t) sx, (uint16_t) sy };
     for (uint32_t x = sx; x <= ex; ++x)
         for (uint32_t y = sy; y <= ey; ++y)
-            cells[x][y].push_back(ent.id);
+            cells[x][y].push_back(ref);
 }
 
+void SpatialHash::remove(Entity const &) {}
+
+//always up to date
+void SpatialHash::build() {}
+
+//two entities share every cell in the overlap of their cell ranges, and the pair
+//is only reported from the first of those (the owner cell), so no pair repeats
 void SpatialHash::collide(std::function<void(Simulation *, Entity &, Entity &)> on_collide) {
-    std::unordered_set<uint32_t> seen_collisions;
     for (uint32_t x = 0; x < MAX_GRID_X; ++x) {
         for (uint32_t y = 0; y < MAX_GRID_Y; ++y) {
-            std::vector<EntityID> const &cell = cells[x][y];
+            std::vector<SpatialHashCellRef> const &cell = cells[x][y];
             for (uint32_t i = 0; i < cell.size(); ++i) {
                 for (uint32_t j = i + 1; j < cell.size(); ++j) {
-                    uint32_t comb_hash = _hash_two(cell[i], cell[j]);
-                    if (seen_collisions.contains(comb_hash)) continue;
-                    on_collide(simulation, simulation->get_ent(cell[i]), simulation->get_ent(cell[j]));
-                    seen_collisions.insert(comb_hash);
+                    if (std::max(cell[i].sx, cell[j].sx) != x || std::max(cell[i].sy, cell[j].sy) != y) continue;
+                    on_collide(simulation, simulation->get_ent(cell[i].id), simulation->get_ent(cell[j].id));
                 }
             }
         }
     }
 }
 
-void SpatialHash::query(float x, float y, float w, float h, std::function<void(Simulation *, Entity &)> cb) {
-    std::unordered_set<EntityID::id_type> seen_entities;
+Entity &SpatialHash::_entity(EntityID const &id) {
+    return simulation->get_ent(id);
+}
+
+//an entity that covers several of the queried cells is only returned from the first
+//of them, like pairs in collide(). nothing is written, so queries can run in parallel
+void SpatialHash::query(float x, float y, float w, float h, std::vector<EntityID> &out) {
     uint32_t sx = fclamp(x - w, 0, ARENA_WIDTH - 1) / GRID_SIZE;
     uint32_t sy = fclamp(y - h, 0, ARENA_HEIGHT - 1) / GRID_SIZE;
     uint32_t ex = fclamp(x + w, 0, ARENA_WIDTH - 1) / GRID_SIZE;
     uint32_t ey = fclamp(y + h, 0, ARENA_HEIGHT - 1) / GRID_SIZE;
     for (uint32_t _x = sx; _x <= ex; ++_x) {
         for (uint32_t _y = sy; _y <= ey; ++_y) {
-            std::vector<EntityID> const &cell = cells[_x][_y];
+            std::vector<SpatialHashCellRef> const &cell = cells[_x][_y];
             for (uint32_t i = 0; i < cell.size(); ++i) {
-                Entity &ent = simulation->get_ent(cell[i]);
+                if (std::max<uint32_t>(cell[i].sx, sx) != _x || std::max<uint32_t>(cell[i].sy, sy) != _y) continue;
+                Entity &ent = simulation->get_ent(cell[i].id);
                 if (ent.get_x() + ent.get_radius() < x - w) continue;
                 if (ent.get_x() - ent.get_radius() > x + w) continue;
                 if (ent.get_y() + ent.get_radius() < y - h) continue;
                 if (ent.get_y() - ent.get_radius() > y + h) continue;
-                if (seen_entities.contains(cell[i].id)) continue;
-                cb(simulation, ent);
-                seen_entities.insert(cell[i].id);
+                out.push_back(cell[i].id);
             }
         }
     }
-}
\ No newline at end of file
+}
+
+//an entity covers its center's cell, so it turns up no later than that cell's ring
+void SpatialHash::_gather_ring(uint32_t cx, uint32_t cy, uint32_t ring, std::vector<SpatialHashCandidate> &out) {
+    for_each_ring_cell(cx, cy, ring, width, height, [&](uint32_t x, uint32_t y) {
+        for (SpatialHashCellRef const &ref : cells[x][y]) {
+            Entity &ent = simulation->get_ent(ref.id);
+            out.push_back({ ref.id, ent.get_x(), ent.get_y() });
+        }
+    });
+}
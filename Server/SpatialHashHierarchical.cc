@@ -0,0 +1,215 @@
+#include <Server/SpatialHash.hh>
+
+#include <Server/Narrowphase.hh>
+#include <Shared/Simulation.hh>
+#include <Shared/Entity.hh>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+static uint32_t _cell_of(SpatialHashLevel const &level, float x, float y) {
+    uint32_t cx = fclamp(x, 0, ARENA_WIDTH - 1) / level.cell_size;
+    uint32_t cy = fclamp(y, 0, ARENA_HEIGHT - 1) / level.cell_size;
+    return cx * level.grid_y + cy;
+}
+
+//stable, so each cell keeps insertion order
+static void _counting_sort(SpatialHashLevel &level) {
+    std::vector<uint32_t> &cell_start = level.cell_start;
+    uint32_t const num_cells = level.grid_x * level.grid_y;
+    std::fill(cell_start.begin(), cell_start.end(), 0);
+    for (SpatialHashEntry const &entry : level.pending)
+        ++cell_start[_cell_of(level, entry.x, entry.y) + 1];
+    for (uint32_t c = 0; c < num_cells; ++c)
+        cell_start[c + 1] += cell_start[c];
+    level.entries.resize(level.pending.size());
+    //cell_start[c] is used as the write cursor for cell c - 1, and ends up where cell c starts
+    for (SpatialHashEntry const &entry : level.pending)
+        level.entries[cell_start[_cell_of(level, entry.x, entry.y)]++] = entry;
+    for (uint32_t c = num_cells; c > 0; --c)
+        cell_start[c] = cell_start[c - 1];
+    cell_start[0] = 0;
+    SpatialHashLanes &lanes = level.lanes;
+    lanes.x.resize(level.entries.size());
+    lanes.y.resize(level.entries.size());
+    lanes.radius.resize(level.entries.size());
+    for (uint32_t i = 0; i < level.entries.size(); ++i) {
+        lanes.x[i] = level.entries[i].x;
+        lanes.y[i] = level.entries[i].y;
+        lanes.radius[i] = level.entries[i].radius;
+    }
+}
+
+SpatialHash::SpatialHash(Simulation *sim) : simulation(sim), sorted(1), width(1), height(1) {
+    for (uint32_t cell_size = GRID_SIZE; ; cell_size *= 2) {
+        SpatialHashLevel &level = levels.emplace_back();
+        level.cell_size = cell_size;
+        level.grid_x = div_round_up(ARENA_WIDTH, cell_size);
+        level.grid_y = div_round_up(ARENA_HEIGHT, cell_size);
+        level.max_radius = 0;
+        level.cell_start.assign(level.grid_x * level.grid_y + 1, 0);
+        if (level.grid_x == 1 && level.grid_y == 1) break;
+    }
+}
+
+void SpatialHash::refresh(uint32_t _width, uint32_t _height) {
+    DEBUG_ONLY(assert(_width <= ARENA_WIDTH && _height <= ARENA_HEIGHT));
+    width = div_round_up(_width, GRID_SIZE);
+    height = div_round_up(_height, GRID_SIZE);
+    begin_tick();
+}
+
+//rebuilt from scratch every tick
+void SpatialHash::begin_tick() {
+    for (SpatialHashLevel &level : levels) {
+        level.pending.clear();
+        level.max_radius = 0;
+    }
+    sorted = 0;
+}
+
+void SpatialHash::insert(Entity &ent) {
+    DEBUG_ONLY(assert(ent.has_component(kPhysics));)
+    SpatialHashEntry const entry = { ent.get_x(), ent.get_y(), ent.get_radius(), ent.id, CollisionFilter(ent) };
+    uint32_t l = 0;
+    while (l + 1 < levels.size() && entry.radius * 2 > levels[l].cell_size) ++l;
+    SpatialHashLevel &level = levels[l];
+    level.pending.push_back(entry);
+    level.max_radius = std::max(level.max_radius, entry.radius);
+    sorted = 0;
+}
+
+void SpatialHash::remove(Entity const &) {}
+
+void SpatialHash::build() {
+    if (sorted) return;
+    occupied.clear();
+    for (uint32_t l = 0; l < levels.size(); ++l) {
+        _counting_sort(levels[l]);
+        if (!levels[l].entries.empty()) occupied.push_back(l);
+    }
+    sorted = 1;
+}
+
+//only pairs that overlap (as of insert) and that on_collide would not ignore are reported
+void SpatialHash::collide(std::function<void(Simulation *, Entity &, Entity &)> on_collide) {
+    build();
+    Narrowphase::Kernel const kernel = Narrowphase::selected().kernel;
+    size_t largest = 0;
+    for (SpatialHashLevel const &level : levels)
+        largest = std::max(largest, level.entries.size());
+    hits.resize(largest);
+    //entries [begin, end) of a level against a
+    auto test_span = [&](SpatialHashEntry const &a, SpatialHashLevel const &level, uint32_t begin, uint32_t end) {
+        if (begin >= end) return;
+        uint32_t const count = kernel(a.x, a.y, a.radius, level.lanes.x.data() + begin,
+            level.lanes.y.data() + begin, level.lanes.radius.data() + begin, end - begin, hits.data());
+        for (uint32_t k = 0; k < count; ++k) {
+            SpatialHashEntry const &b = level.entries[begin + hits[k]];
+            if (collision_filters_interact(a.filter, b.filter))
+                on_collide(simulation, simulation->get_ent(a.id), simulation->get_ent(b.id));
+        }
+    };
+    for (uint32_t o = 0; o < occupied.size(); ++o) {
+        SpatialHashLevel const &level = levels[occupied[o]];
+        uint32_t const gx = level.grid_x, gy = level.grid_y;
+        for (uint32_t x = 0; x < gx; ++x) {
+            for (uint32_t y = 0; y < gy; ++y) {
+                uint32_t const cell = x * gy + y;
+                uint32_t const sy = y > 0 ? y - 1 : 0, ey = std::min(y + 1, gy - 1);
+                //the rest of this cell and the cell below it are adjacent in entries,
+                //as are cells [sy, ey] of the next column
+                uint32_t const below_end = level.cell_start[y < gy - 1 ? cell + 2 : cell + 1];
+                uint32_t next_begin = 0, next_end = 0;
+                if (x < gx - 1) {
+                    next_begin = level.cell_start[(x + 1) * gy + sy];
+                    next_end = level.cell_start[(x + 1) * gy + ey + 1];
+                }
+                for (uint32_t i = level.cell_start[cell]; i < level.cell_start[cell + 1]; ++i) {
+                    SpatialHashEntry const &a = level.entries[i];
+                    test_span(a, level, i + 1, below_end);
+                    test_span(a, level, next_begin, next_end);
+                    //every finer level: the cells a can reach with that level's largest radius.
+                    //there are far fewer large entities than small ones, so this makes a few long
+                    //spans instead of many short ones from the small entities' side
+                    for (uint32_t p = 0; p < o; ++p) {
+                        SpatialHashLevel const &fine = levels[occupied[p]];
+                        float const reach = a.radius + fine.max_radius;
+                        uint32_t const fsx = fclamp(a.x - reach, 0, ARENA_WIDTH - 1) / fine.cell_size;
+                        uint32_t const fsy = fclamp(a.y - reach, 0, ARENA_HEIGHT - 1) / fine.cell_size;
+                        uint32_t const fex = fclamp(a.x + reach, 0, ARENA_WIDTH - 1) / fine.cell_size;
+                        uint32_t const fey = fclamp(a.y + reach, 0, ARENA_HEIGHT - 1) / fine.cell_size;
+                        //columns spanning the whole height are adjacent in entries
+                        if (fsy == 0 && fey == fine.grid_y - 1) {
+                            test_span(a, fine, fine.cell_start[fsx * fine.grid_y], fine.cell_start[(fex + 1) * fine.grid_y]);
+                            continue;
+                        }
+                        for (uint32_t _x = fsx; _x <= fex; ++_x)
+                            test_span(a, fine, fine.cell_start[_x * fine.grid_y + fsy],
+                                fine.cell_start[_x * fine.grid_y + fey + 1]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+Entity &SpatialHash::_entity(EntityID const &id) {
+    return simulation->get_ent(id);
+}
+
+//filters on positions as of insert, which can be a tick old for queries made after the tick
+void SpatialHash::query(float x, float y, float w, float h, std::vector<EntityID> &out) {
+    DEBUG_ONLY(assert(sorted);)
+    for (uint32_t l : occupied) {
+        SpatialHashLevel const &level = levels[l];
+        //nothing on this level reaches further than max_radius out of its cell
+        float const reach = level.max_radius;
+        uint32_t sx = fclamp(x - w - reach, 0, ARENA_WIDTH - 1) / level.cell_size;
+        uint32_t sy = fclamp(y - h - reach, 0, ARENA_HEIGHT - 1) / level.cell_size;
+        uint32_t ex = fclamp(x + w + reach, 0, ARENA_WIDTH - 1) / level.cell_size;
+        uint32_t ey = fclamp(y + h + reach, 0, ARENA_HEIGHT - 1) / level.cell_size;
+        for (uint32_t _x = sx; _x <= ex; ++_x) {
+            uint32_t const end = level.cell_start[_x * level.grid_y + ey + 1];
+            for (uint32_t i = level.cell_start[_x * level.grid_y + sy]; i < end; ++i) {
+                SpatialHashEntry const &entry = level.entries[i];
+                if (entry.x + entry.radius < x - w) continue;
+                if (entry.x - entry.radius > x + w) continue;
+                if (entry.y + entry.radius < y - h) continue;
+                if (entry.y - entry.radius > y + h) continue;
+                out.push_back(entry.id);
+            }
+        }
+    }
+}
+
+//rings are in level 0 cells. a coarser cell can straddle several rings, so its
+//entries are filtered down to the ones whose center is in this ring
+void SpatialHash::_gather_ring(uint32_t cx, uint32_t cy, uint32_t ring, std::vector<SpatialHashCandidate> &out) {
+    DEBUG_ONLY(assert(sorted);)
+    int32_t const sx = (int32_t) cx - (int32_t) ring, ex = cx + ring;
+    int32_t const sy = (int32_t) cy - (int32_t) ring, ey = cy + ring;
+    for (uint32_t l : occupied) {
+        SpatialHashLevel const &level = levels[l];
+        int32_t const lsx = std::max(sx, 0) >> l, lex = std::min(ex, (int32_t) width - 1) >> l;
+        int32_t const lsy = std::max(sy, 0) >> l, ley = std::min(ey, (int32_t) height - 1) >> l;
+        for (int32_t x = lsx; x <= lex; ++x) {
+            for (int32_t y = lsy; y <= ley; ++y) {
+                //cells strictly inside the ring were covered by earlier rings
+                if (ring > 0 && (x << l) > sx && ((x + 1) << l) - 1 < ex && (y << l) > sy && ((y + 1) << l) - 1 < ey)
+                    continue;
+                uint32_t const cell = x * level.grid_y + y;
+                for (uint32_t i = level.cell_start[cell]; i < level.cell_start[cell + 1]; ++i) {
+                    SpatialHashEntry const &entry = level.entries[i];
+                    if (l > 0) {
+                        int32_t bx = fclamp(entry.x, 0, ARENA_WIDTH - 1) / GRID_SIZE;
+                        int32_t by = fclamp(entry.y, 0, ARENA_HEIGHT - 1) / GRID_SIZE;
+                        if (std::max(std::abs(bx - (int32_t) cx), std::abs(by - (int32_t) cy)) != (int32_t) ring) continue;
+                    }
+                    out.push_back({ entry.id, entry.x, entry.y });
+                }
+            }
+        }
+    }
+}
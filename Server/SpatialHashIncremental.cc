@@ -0,0 +1,175 @@
+#include <Server/SpatialHash.hh>
+
+#include <Shared/Simulation.hh>
+#include <Shared/Entity.hh>
+
+#include <algorithm>
+#include <cmath>
+
+static uint32_t const NUM_CELLS = MAX_GRID_X * MAX_GRID_Y;
+static uint32_t const NO_CELL = -1;
+static uint32_t const MIN_CELL_CAPACITY = 4;
+
+SpatialHash::SpatialHash(Simulation *sim) : simulation(sim), cells(NUM_CELLS, {0, 0, 0}), abandoned(0), width(1), height(1) {}
+
+void SpatialHash::refresh(uint32_t _width, uint32_t _height) {
+    DEBUG_ONLY(assert(_width <= ARENA_WIDTH && _height <= ARENA_HEIGHT));
+    width = div_round_up(_width, GRID_SIZE);
+    height = div_round_up(_height, GRID_SIZE);
+    entries.clear();
+    std::fill(cells.begin(), cells.end(), SpatialHashCell{0, 0, 0});
+    slot_cell.assign(simulation->capacity(), NO_CELL);
+    slot_index.assign(simulation->capacity(), 0);
+    abandoned = 0;
+}
+
+void SpatialHash::begin_tick() {
+    if (abandoned > entries.size() / 2) _compact();
+}
+
+void SpatialHash::_add(uint32_t cell_id, SpatialHashEntry const &entry) {
+    SpatialHashCell &cell = cells[cell_id];
+    if (cell.count == cell.capacity) {
+        uint32_t const begin = entries.size();
+        abandoned += cell.capacity;
+        entries.resize(begin + std::max(MIN_CELL_CAPACITY, cell.capacity * 2));
+        for (uint32_t i = 0; i < cell.count; ++i) {
+            entries[begin + i] = entries[cell.begin + i];
+            slot_index[entries[begin + i].id.id] = begin + i;
+        }
+        cell.begin = begin;
+        cell.capacity = entries.size() - begin;
+    }
+    uint32_t const index = cell.begin + cell.count++;
+    entries[index] = entry;
+    slot_cell[entry.id.id] = cell_id;
+    slot_index[entry.id.id] = index;
+}
+
+//swap-removes from the cell's block
+void SpatialHash::_remove(EntityID::id_type slot) {
+    SpatialHashCell &cell = cells[slot_cell[slot]];
+    uint32_t const index = slot_index[slot];
+    uint32_t const last = cell.begin + --cell.count;
+    if (index != last) {
+        entries[index] = entries[last];
+        slot_index[entries[index].id.id] = index;
+    }
+    slot_cell[slot] = NO_CELL;
+}
+
+//lays the cells out again back to back, each with half its count as slack
+void SpatialHash::_compact() {
+    std::vector<SpatialHashEntry> old;
+    old.swap(entries);
+    uint32_t at = 0;
+    for (SpatialHashCell &cell : cells) {
+        uint32_t const capacity = cell.count == 0 ? 0 : std::max(MIN_CELL_CAPACITY, cell.count + cell.count / 2);
+        entries.resize(at + capacity);
+        for (uint32_t i = 0; i < cell.count; ++i) {
+            entries[at + i] = old[cell.begin + i];
+            slot_index[entries[at + i].id.id] = at + i;
+        }
+        cell.begin = at;
+        cell.capacity = capacity;
+        at += capacity;
+    }
+    abandoned = 0;
+}
+
+void SpatialHash::insert(Entity &ent) {
+    DEBUG_ONLY(assert(ent.has_component(kPhysics));)
+    //for the uniform grid to work, the max ent radius is GRID_SIZE/2
+    //if larger entities are needed, either increase the GRID_SIZE
+    //or use SpatialHashHierarchical or SpatialHashCanonical
+    DEBUG_ONLY(assert(ent.get_radius() <= GRID_SIZE / 2);)
+    //its entry is still current
+    if (!ent.spatial_dirty && slot_cell[ent.id.id] != NO_CELL) return;
+    ent.spatial_dirty = 0;
+    uint32_t x = fclamp(ent.get_x(), 0, ARENA_WIDTH - 1) / GRID_SIZE;
+    uint32_t y = fclamp(ent.get_y(), 0, ARENA_HEIGHT - 1) / GRID_SIZE;
+    uint32_t const cell = x * MAX_GRID_Y + y;
+    SpatialHashEntry const entry = { ent.get_x(), ent.get_y(), ent.get_radius(), ent.id, CollisionFilter(ent) };
+    EntityID::id_type const slot = ent.id.id;
+    if (slot_cell[slot] == cell) {
+        entries[slot_index[slot]] = entry;
+        return;
+    }
+    if (slot_cell[slot] != NO_CELL) _remove(slot);
+    _add(cell, entry);
+}
+
+void SpatialHash::remove(Entity const &ent) {
+    if (slot_cell[ent.id.id] != NO_CELL) _remove(ent.id.id);
+}
+
+//pairs whose bounding boxes (as of insert) do not touch, or that
+//on_collide would ignore anyway, are never reported
+static bool _may_collide(SpatialHashEntry const &a, SpatialHashEntry const &b) {
+    float min_dist = a.radius + b.radius;
+    if (fabsf(a.x - b.x) > min_dist || fabsf(a.y - b.y) > min_dist) return false;
+    return collision_filters_interact(a.filter, b.filter);
+}
+
+//always up to date
+void SpatialHash::build() {}
+
+void SpatialHash::collide(std::function<void(Simulation *, Entity &, Entity &)> on_collide) {
+    auto test_cell = [&](SpatialHashEntry const &a, uint32_t cell) {
+        uint32_t const end = cells[cell].begin + cells[cell].count;
+        for (uint32_t j = cells[cell].begin; j < end; ++j)
+            if (_may_collide(a, entries[j]))
+                on_collide(simulation, simulation->get_ent(a.id), simulation->get_ent(entries[j].id));
+    };
+    for (uint32_t x = 0; x < MAX_GRID_X; ++x) {
+        for (uint32_t y = 0; y < MAX_GRID_Y; ++y) {
+            uint32_t const cell = x * MAX_GRID_Y + y;
+            uint32_t const end = cells[cell].begin + cells[cell].count;
+            for (uint32_t i = cells[cell].begin; i < end; ++i) {
+                SpatialHashEntry const &a = entries[i];
+                for (uint32_t j = i + 1; j < end; ++j)
+                    if (_may_collide(a, entries[j]))
+                        on_collide(simulation, simulation->get_ent(a.id), simulation->get_ent(entries[j].id));
+                if (x < MAX_GRID_X - 1) {
+                    test_cell(a, cell + MAX_GRID_Y);
+                    if (y > 0) test_cell(a, cell + MAX_GRID_Y - 1);
+                    if (y < MAX_GRID_Y - 1) test_cell(a, cell + MAX_GRID_Y + 1);
+                }
+                if (y < MAX_GRID_Y - 1) test_cell(a, cell + 1);
+            }
+        }
+    }
+}
+
+Entity &SpatialHash::_entity(EntityID const &id) {
+    return simulation->get_ent(id);
+}
+
+//filters on positions as of insert, which can be a tick old for queries made after the tick
+void SpatialHash::query(float x, float y, float w, float h, std::vector<EntityID> &out) {
+    uint32_t sx = fclamp(x - w - GRID_SIZE / 2, 0, ARENA_WIDTH - 1) / GRID_SIZE;
+    uint32_t sy = fclamp(y - h - GRID_SIZE / 2, 0, ARENA_HEIGHT - 1) / GRID_SIZE;
+    uint32_t ex = fclamp(x + w + GRID_SIZE / 2, 0, ARENA_WIDTH - 1) / GRID_SIZE;
+    uint32_t ey = fclamp(y + h + GRID_SIZE / 2, 0, ARENA_HEIGHT - 1) / GRID_SIZE;
+    for (uint32_t _x = sx; _x <= ex; ++_x) {
+        for (uint32_t _y = sy; _y <= ey; ++_y) {
+            SpatialHashCell const &cell = cells[_x * MAX_GRID_Y + _y];
+            for (uint32_t i = cell.begin; i < cell.begin + cell.count; ++i) {
+                SpatialHashEntry const &entry = entries[i];
+                if (entry.x + entry.radius < x - w) continue;
+                if (entry.x - entry.radius > x + w) continue;
+                if (entry.y + entry.radius < y - h) continue;
+                if (entry.y - entry.radius > y + h) continue;
+                out.push_back(entry.id);
+            }
+        }
+    }
+}
+
+void SpatialHash::_gather_ring(uint32_t cx, uint32_t cy, uint32_t ring, std::vector<SpatialHashCandidate> &out) {
+    for_each_ring_cell(cx, cy, ring, width, height, [&](uint32_t x, uint32_t y) {
+        SpatialHashCell const &cell = cells[x * MAX_GRID_Y + y];
+        for (uint32_t i = cell.begin; i < cell.begin + cell.count; ++i)
+            out.push_back({ entries[i].id, entries[i].x, entries[i].y });
+    });
+}
@@ -0,0 +1,199 @@
+#include <Server/SpatialHash.hh>
+
+#include <Server/Narrowphase.hh>
+#include <Shared/Simulation.hh>
+#include <Shared/Entity.hh>
+
+#include <algorithm>
+#include <cmath>
+
+static uint32_t const NO_CELL = -1;
+static uint32_t const EMPTY_KEY = -1;
+static uint32_t const MIN_TABLE_SIZE = 64;
+//x and y are 16 bits each, and (65535, 65535) is EMPTY_KEY
+static uint32_t const MAX_CELLS_PER_SIDE = 65535;
+
+static uint32_t _key(uint32_t x, uint32_t y) {
+    return (x << 16) | y;
+}
+
+//the cell of a coordinate along a side that is cells long
+static uint32_t _cell_of(float v, uint32_t cells) {
+    return fclamp(v, 0, cells * GRID_SIZE - 1) / GRID_SIZE;
+}
+
+//fibonacci hashing: the top bits of the product, table_size is a power of two
+static uint32_t _slot_of(uint32_t key, uint32_t table_size) {
+    return (key * 0x9E3779B1u) >> (32 - __builtin_ctz(table_size));
+}
+
+SpatialHash::SpatialHash(Simulation *sim) : simulation(sim), sorted(1), width(1), height(1) {}
+
+void SpatialHash::refresh(uint32_t _width, uint32_t _height) {
+    width = div_round_up(_width, GRID_SIZE);
+    height = div_round_up(_height, GRID_SIZE);
+    DEBUG_ONLY(assert(width < MAX_CELLS_PER_SIDE && height < MAX_CELLS_PER_SIDE);)
+    begin_tick();
+}
+
+//rebuilt from scratch every tick
+void SpatialHash::begin_tick() {
+    pending.clear();
+    sorted = 0;
+}
+
+void SpatialHash::insert(Entity &ent) {
+    DEBUG_ONLY(assert(ent.has_component(kPhysics));)
+    //same limit as the uniform grid
+    DEBUG_ONLY(assert(ent.get_radius() <= GRID_SIZE / 2);)
+    pending.push_back({ ent.get_x(), ent.get_y(), ent.get_radius(), ent.id, CollisionFilter(ent) });
+    sorted = 0;
+}
+
+void SpatialHash::remove(Entity const &) {}
+
+uint32_t SpatialHash::_find(uint32_t key) const {
+    for (uint32_t slot = _slot_of(key, table.size()); ; slot = (slot + 1) & (table.size() - 1)) {
+        if (table[slot].key == key) return table[slot].cell;
+        if (table[slot].key == EMPTY_KEY) return NO_CELL;
+    }
+}
+
+//cells are numbered in coordinate order (x, then y), like the uniform grid's cells,
+//so cells [(x, sy), (x, ey)] of a column are adjacent in entries
+void SpatialHash::build() {
+    if (sorted) return;
+    //at most one cell per entity, and kept at most half full
+    uint32_t table_size = MIN_TABLE_SIZE;
+    while (table_size < pending.size() * 2) table_size *= 2;
+    table.assign(table_size, { EMPTY_KEY, NO_CELL });
+    cell_keys.clear();
+    pending_cell.resize(pending.size());
+    for (uint32_t i = 0; i < pending.size(); ++i) {
+        uint32_t const key = _key(_cell_of(pending[i].x, width), _cell_of(pending[i].y, height));
+        uint32_t slot = _slot_of(key, table_size);
+        while (table[slot].key != key && table[slot].key != EMPTY_KEY)
+            slot = (slot + 1) & (table_size - 1);
+        if (table[slot].key == EMPTY_KEY) {
+            table[slot] = { key, (uint32_t) cell_keys.size() };
+            cell_keys.push_back(key);
+        }
+        pending_cell[i] = table[slot].cell;
+    }
+    //renumber from first-seen to coordinate order: sorting key << 32 | first-seen
+    //number sorts by key and keeps track of where each cell went
+    renumber.resize(cell_keys.size());
+    cell_order.resize(cell_keys.size());
+    for (uint32_t c = 0; c < cell_keys.size(); ++c)
+        cell_order[c] = ((uint64_t) cell_keys[c] << 32) | c;
+    std::sort(cell_order.begin(), cell_order.end());
+    for (uint32_t c = 0; c < cell_keys.size(); ++c) {
+        cell_keys[c] = cell_order[c] >> 32;
+        renumber[(uint32_t) cell_order[c]] = c;
+    }
+    for (SpatialHashTableSlot &slot : table)
+        if (slot.key != EMPTY_KEY) slot.cell = renumber[slot.cell];
+    //then the same counting sort as the uniform grid
+    cell_start.assign(cell_keys.size() + 1, 0);
+    for (uint32_t &cell : pending_cell) {
+        cell = renumber[cell];
+        ++cell_start[cell + 1];
+    }
+    for (uint32_t c = 0; c < cell_keys.size(); ++c)
+        cell_start[c + 1] += cell_start[c];
+    //cell_start[c] is used as the write cursor for cell c, and ends up where cell c + 1 starts
+    entries.resize(pending.size());
+    for (uint32_t i = 0; i < pending.size(); ++i)
+        entries[cell_start[pending_cell[i]]++] = pending[i];
+    for (uint32_t c = cell_keys.size(); c > 0; --c)
+        cell_start[c] = cell_start[c - 1];
+    cell_start[0] = 0;
+    lanes.x.resize(entries.size());
+    lanes.y.resize(entries.size());
+    lanes.radius.resize(entries.size());
+    for (uint32_t i = 0; i < entries.size(); ++i) {
+        lanes.x[i] = entries[i].x;
+        lanes.y[i] = entries[i].y;
+        lanes.radius[i] = entries[i].radius;
+    }
+    sorted = 1;
+}
+
+//the occupied cells among (x, sy) to (x, ey) are numbered consecutively
+void SpatialHash::_column(uint32_t x, uint32_t sy, uint32_t ey, uint32_t &begin, uint32_t &end) const {
+    begin = end = 0;
+    for (uint32_t y = sy; y <= ey; ++y) {
+        uint32_t first = _find(_key(x, y));
+        if (first == NO_CELL) continue;
+        uint32_t last = first;
+        while (last + 1 < cell_keys.size() && cell_keys[last + 1] <= _key(x, ey)) ++last;
+        begin = cell_start[first];
+        end = cell_start[last + 1];
+        return;
+    }
+}
+
+//only pairs that overlap (as of insert) and that on_collide would not ignore are reported
+void SpatialHash::collide(std::function<void(Simulation *, Entity &, Entity &)> on_collide) {
+    build();
+    Narrowphase::Kernel const kernel = Narrowphase::selected().kernel;
+    hits.resize(entries.size());
+    auto test_span = [&](SpatialHashEntry const &a, uint32_t begin, uint32_t end) {
+        if (begin >= end) return;
+        uint32_t const count = kernel(a.x, a.y, a.radius, lanes.x.data() + begin,
+            lanes.y.data() + begin, lanes.radius.data() + begin, end - begin, hits.data());
+        for (uint32_t k = 0; k < count; ++k) {
+            SpatialHashEntry const &b = entries[begin + hits[k]];
+            if (collision_filters_interact(a.filter, b.filter))
+                on_collide(simulation, simulation->get_ent(a.id), simulation->get_ent(b.id));
+        }
+    };
+    for (uint32_t c = 0; c < cell_keys.size(); ++c) {
+        uint32_t const x = cell_keys[c] >> 16, y = cell_keys[c] & 0xffff;
+        //the rest of this cell and the cell below it (if occupied) are adjacent in entries,
+        //as are the occupied cells among (x + 1, y - 1) to (x + 1, y + 1)
+        uint32_t const below = c + 1 < cell_keys.size() && cell_keys[c + 1] == _key(x, y + 1) ? c + 2 : c + 1;
+        uint32_t next_begin, next_end;
+        _column(x + 1, y > 0 ? y - 1 : 0, y + 1, next_begin, next_end);
+        for (uint32_t i = cell_start[c]; i < cell_start[c + 1]; ++i) {
+            SpatialHashEntry const &a = entries[i];
+            test_span(a, i + 1, cell_start[below]);
+            test_span(a, next_begin, next_end);
+        }
+    }
+}
+
+Entity &SpatialHash::_entity(EntityID const &id) {
+    return simulation->get_ent(id);
+}
+
+//filters on positions as of insert, which can be a tick old for queries made after the tick
+void SpatialHash::query(float x, float y, float w, float h, std::vector<EntityID> &out) {
+    DEBUG_ONLY(assert(sorted);)
+    uint32_t sx = _cell_of(x - w - GRID_SIZE / 2, width);
+    uint32_t sy = _cell_of(y - h - GRID_SIZE / 2, height);
+    uint32_t ex = _cell_of(x + w + GRID_SIZE / 2, width);
+    uint32_t ey = _cell_of(y + h + GRID_SIZE / 2, height);
+    for (uint32_t _x = sx; _x <= ex; ++_x) {
+        uint32_t begin, end;
+        _column(_x, sy, ey, begin, end);
+        for (uint32_t i = begin; i < end; ++i) {
+            SpatialHashEntry const &entry = entries[i];
+            if (entry.x + entry.radius < x - w) continue;
+            if (entry.x - entry.radius > x + w) continue;
+            if (entry.y + entry.radius < y - h) continue;
+            if (entry.y - entry.radius > y + h) continue;
+            out.push_back(entry.id);
+        }
+    }
+}
+
+void SpatialHash::_gather_ring(uint32_t cx, uint32_t cy, uint32_t ring, std::vector<SpatialHashCandidate> &out) {
+    DEBUG_ONLY(assert(sorted);)
+    for_each_ring_cell(cx, cy, ring, width, height, [&](uint32_t x, uint32_t y) {
+        uint32_t const c = _find(_key(x, y));
+        if (c == NO_CELL) return;
+        for (uint32_t i = cell_start[c]; i < cell_start[c + 1]; ++i)
+            out.push_back({ entries[i].id, entries[i].x, entries[i].y });
+    });
+}
@@ -1,73 +1,197 @@
 #include <Server/SpatialHash.hh>
 
+#include <Server/Narrowphase.hh>
+
 #include <Shared/Simulation.hh>
 #include <Shared/Entity.hh>
 
-SpatialHash::SpatialHash(Simulation *sim) : simulation(sim), width(1), height(1) {}
+#include <algorithm>
+#include <cmath>
+
+static uint32_t const NUM_CELLS = MAX_GRID_X * MAX_GRID_Y;
+static uint32_t const NOT_STATIC = -1;
+
+static uint32_t _cell_of(SpatialHashEntry const &entry) {
+    uint32_t x = fclamp(entry.x, 0, ARENA_WIDTH - 1) / GRID_SIZE;
+    uint32_t y = fclamp(entry.y, 0, ARENA_HEIGHT - 1) / GRID_SIZE;
+    return x * MAX_GRID_Y + y;
+}
+
+//stable, so each cell keeps insertion order
+static void _counting_sort(std::vector<SpatialHashEntry> const &from, std::vector<SpatialHashEntry> &to,
+    SpatialHashLanes &lanes, std::vector<uint32_t> &cell_start) {
+    std::fill(cell_start.begin(), cell_start.end(), 0);
+    for (SpatialHashEntry const &entry : from)
+        ++cell_start[_cell_of(entry) + 1];
+    for (uint32_t c = 0; c < NUM_CELLS; ++c)
+        cell_start[c + 1] += cell_start[c];
+    to.resize(from.size());
+    //cell_start[c] is used as the write cursor for cell c - 1, and ends up where cell c starts
+    for (SpatialHashEntry const &entry : from)
+        to[cell_start[_cell_of(entry)]++] = entry;
+    for (uint32_t c = NUM_CELLS; c > 0; --c)
+        cell_start[c] = cell_start[c - 1];
+    cell_start[0] = 0;
+    lanes.x.resize(to.size());
+    lanes.y.resize(to.size());
+    lanes.radius.resize(to.size());
+    for (uint32_t i = 0; i < to.size(); ++i) {
+        lanes.x[i] = to[i].x;
+        lanes.y[i] = to[i].y;
+        lanes.radius[i] = to[i].radius;
+    }
+}
+
+//entities that (almost) never move. one that does move just costs a static re-sort
+static bool _is_static(Entity const &ent) {
+    if (ent.has_component(kDrop) || ent.has_component(kWeb)) return true;
+    return ent.has_component(kMob) && MOB_DATA[ent.get_mob_id()].attributes.stationary;
+}
+
+SpatialHash::SpatialHash(Simulation *sim) : simulation(sim), cell_start(NUM_CELLS + 1, 0), sorted(1),
+    static_cell_start(NUM_CELLS + 1, 0), static_sorted(1), width(1), height(1) {}
 
 void SpatialHash::refresh(uint32_t _width, uint32_t _height) {
     DEBUG_ONLY(assert(_width <= ARENA_WIDTH && _height <= ARENA_HEIGHT));
     width = div_round_up(_width, GRID_SIZE);
     height = div_round_up(_height, GRID_SIZE);
-    for (uint32_t x = 0; x < MAX_GRID_X; ++x)
-        for (uint32_t y = 0; y < MAX_GRID_Y; ++y)
-            cells[x][y].clear();
+    pending.clear();
+    sorted = 0;
+    static_list.clear();
+    static_list_index.assign(simulation->capacity(), NOT_STATIC);
+    static_sorted = 0;
 }
 
-void SpatialHash::insert(Entity const &ent) {
+//the dynamic layer is rebuilt from scratch every tick
+void SpatialHash::begin_tick() {
+    pending.clear();
+    sorted = 0;
+}
+
+void SpatialHash::insert(Entity &ent) {
     DEBUG_ONLY(assert(ent.has_component(kPhysics));)
     //for the uniform grid to work, the max ent radius is GRID_SIZE/2
     //if larger entities are needed, either increase the GRID_SIZE
-    //or use SpatialHashCanonical
+    //or use SpatialHashHierarchical or SpatialHashCanonical
     DEBUG_ONLY(assert(ent.get_radius() <= GRID_SIZE / 2);)
-    uint32_t x = fclamp(ent.get_x(), 0, ARENA_WIDTH - 1) / GRID_SIZE;
-    uint32_t y = fclamp(ent.get_y(), 0, ARENA_HEIGHT - 1) / GRID_SIZE;
-    cells[x][y].push_back(ent.id);
+    SpatialHashEntry const entry = { ent.get_x(), ent.get_y(), ent.get_radius(), ent.id, CollisionFilter(ent) };
+    EntityID::id_type const slot = ent.id.id;
+    if (!_is_static(ent)) {
+        if (static_list_index[slot] != NOT_STATIC) _unlist_static(slot);
+        pending.push_back(entry);
+        sorted = 0;
+        return;
+    }
+    if (static_list_index[slot] == NOT_STATIC) {
+        static_list_index[slot] = static_list.size();
+        static_list.push_back(entry);
+        static_sorted = 0;
+        return;
+    }
+    SpatialHashEntry &listed = static_list[static_list_index[slot]];
+    if (listed.x == entry.x && listed.y == entry.y && listed.radius == entry.radius) return;
+    listed = entry;
+    static_sorted = 0;
 }
 
+void SpatialHash::_unlist_static(EntityID::id_type slot) {
+    uint32_t const index = static_list_index[slot];
+    static_list[index] = static_list.back();
+    static_list_index[static_list[index].id.id] = index;
+    static_list.pop_back();
+    static_list_index[slot] = NOT_STATIC;
+    static_sorted = 0;
+}
+
+void SpatialHash::remove(Entity const &ent) {
+    if (static_list_index[ent.id.id] != NOT_STATIC) _unlist_static(ent.id.id);
+}
+
+void SpatialHash::build() {
+    if (!sorted) _counting_sort(pending, entries, lanes, cell_start);
+    if (!static_sorted) _counting_sort(static_list, static_entries, static_lanes, static_cell_start);
+    sorted = static_sorted = 1;
+}
+
+//only pairs that overlap (as of insert) and that on_collide would not ignore are reported
 void SpatialHash::collide(std::function<void(Simulation *, Entity &, Entity &)> on_collide) {
+    build();
+    Narrowphase::Kernel const kernel = Narrowphase::selected().kernel;
+    hits.resize(std::max(entries.size(), static_entries.size()));
+    //entries [begin, end) of a layer against a
+    auto test_span = [&](SpatialHashEntry const &a, std::vector<SpatialHashEntry> const &layer,
+        SpatialHashLanes const &layer_lanes, uint32_t begin, uint32_t end) {
+        if (begin >= end) return;
+        uint32_t const count = kernel(a.x, a.y, a.radius, layer_lanes.x.data() + begin,
+            layer_lanes.y.data() + begin, layer_lanes.radius.data() + begin, end - begin, hits.data());
+        for (uint32_t k = 0; k < count; ++k) {
+            SpatialHashEntry const &b = layer[begin + hits[k]];
+            if (collision_filters_interact(a.filter, b.filter))
+                on_collide(simulation, simulation->get_ent(a.id), simulation->get_ent(b.id));
+        }
+    };
     for (uint32_t x = 0; x < MAX_GRID_X; ++x) {
         for (uint32_t y = 0; y < MAX_GRID_Y; ++y) {
-            std::vector<EntityID> &cell = cells[x][y];
-            for (uint32_t i = 0; i < cell.size(); ++i) {
-                for (uint32_t j = i + 1; j < cell.size(); ++j) on_collide(simulation, simulation->get_ent(cell[i]), simulation->get_ent(cell[j]));
-                if (x < MAX_GRID_X - 1) {
-                    std::vector<EntityID> &cell2 = cells[x+1][y];
-                    for (uint32_t j = 0; j < cell2.size(); ++j) on_collide(simulation, simulation->get_ent(cell[i]), simulation->get_ent(cell2[j]));
-                    if (y > 0) {
-                        std::vector<EntityID> &cell2 = cells[x+1][y-1];
-                        for (uint32_t j = 0; j < cell2.size(); ++j) on_collide(simulation, simulation->get_ent(cell[i]), simulation->get_ent(cell2[j]));
-                    }
-                    if (y < MAX_GRID_Y - 1) {
-                        std::vector<EntityID> &cell2 = cells[x+1][y+1];
-                        for (uint32_t j = 0; j < cell2.size(); ++j) on_collide(simulation, simulation->get_ent(cell[i]), simulation->get_ent(cell2[j]));
-                    }
-                }
-                if (y < MAX_GRID_Y - 1) {
-                    std::vector<EntityID> &cell2 = cells[x][y+1];
-                    for (uint32_t j = 0; j < cell2.size(); ++j) on_collide(simulation, simulation->get_ent(cell[i]), simulation->get_ent(cell2[j]));
-                }
+            uint32_t const cell = x * MAX_GRID_Y + y;
+            uint32_t const sy = y > 0 ? y - 1 : 0, ey = std::min(y + 1, MAX_GRID_Y - 1);
+            //the rest of this cell and the cell below it are adjacent in entries,
+            //as are cells [sy, ey] of the next column
+            uint32_t const below_end = cell_start[y < MAX_GRID_Y - 1 ? cell + 2 : cell + 1];
+            uint32_t next_begin = 0, next_end = 0;
+            if (x < MAX_GRID_X - 1) {
+                next_begin = cell_start[(x + 1) * MAX_GRID_Y + sy];
+                next_end = cell_start[(x + 1) * MAX_GRID_Y + ey + 1];
+            }
+            for (uint32_t i = cell_start[cell]; i < cell_start[cell + 1]; ++i) {
+                SpatialHashEntry const &a = entries[i];
+                test_span(a, entries, lanes, i + 1, below_end);
+                test_span(a, entries, lanes, next_begin, next_end);
+                //static entries do not show up in the dynamic half-neighbourhood walk,
+                //so every dynamic entry checks the full 3x3 block of the static layer
+                for (uint32_t _x = x > 0 ? x - 1 : 0; _x <= std::min(x + 1, MAX_GRID_X - 1); ++_x)
+                    test_span(a, static_entries, static_lanes, static_cell_start[_x * MAX_GRID_Y + sy],
+                        static_cell_start[_x * MAX_GRID_Y + ey + 1]);
             }
         }
     }
 }
 
-void SpatialHash::query(float x, float y, float w, float h, std::function<void(Simulation *, Entity &)> cb) {
+Entity &SpatialHash::_entity(EntityID const &id) {
+    return simulation->get_ent(id);
+}
+
+//filters on positions as of insert, which can be a tick old for queries made after the tick
+void SpatialHash::query(float x, float y, float w, float h, std::vector<EntityID> &out) {
+    DEBUG_ONLY(assert(sorted && static_sorted);)
     uint32_t sx = fclamp(x - w - GRID_SIZE / 2, 0, ARENA_WIDTH - 1) / GRID_SIZE;
     uint32_t sy = fclamp(y - h - GRID_SIZE / 2, 0, ARENA_HEIGHT - 1) / GRID_SIZE;
     uint32_t ex = fclamp(x + w + GRID_SIZE / 2, 0, ARENA_WIDTH - 1) / GRID_SIZE;
     uint32_t ey = fclamp(y + h + GRID_SIZE / 2, 0, ARENA_HEIGHT - 1) / GRID_SIZE;
-    for (uint32_t _x = sx; _x <= ex; ++_x) {
-        for (uint32_t _y = sy; _y <= ey; ++_y) {
-            std::vector<EntityID> &cell = cells[_x][_y];
-            for (uint32_t i = 0; i < cell.size(); ++i) {
-                Entity &ent = simulation->get_ent(cell[i]);
-                if (ent.get_x() + ent.get_radius() < x - w) continue;
-                if (ent.get_x() - ent.get_radius() > x + w) continue;
-                if (ent.get_y() + ent.get_radius() < y - h) continue;
-                if (ent.get_y() - ent.get_radius() > y + h) continue;
-                cb(simulation, ent);
+    auto scan = [&](std::vector<SpatialHashEntry> const &layer, std::vector<uint32_t> const &starts) {
+        for (uint32_t _x = sx; _x <= ex; ++_x) {
+            //cells [sy, ey] of a column are adjacent in the layer
+            uint32_t const end = starts[_x * MAX_GRID_Y + ey + 1];
+            for (uint32_t i = starts[_x * MAX_GRID_Y + sy]; i < end; ++i) {
+                SpatialHashEntry const &entry = layer[i];
+                if (entry.x + entry.radius < x - w) continue;
+                if (entry.x - entry.radius > x + w) continue;
+                if (entry.y + entry.radius < y - h) continue;
+                if (entry.y - entry.radius > y + h) continue;
+                out.push_back(entry.id);
             }
         }
-    }
+    };
+    scan(entries, cell_start);
+    scan(static_entries, static_cell_start);
+}
+
+void SpatialHash::_gather_ring(uint32_t cx, uint32_t cy, uint32_t ring, std::vector<SpatialHashCandidate> &out) {
+    DEBUG_ONLY(assert(sorted && static_sorted);)
+    for_each_ring_cell(cx, cy, ring, width, height, [&](uint32_t x, uint32_t y) {
+        uint32_t const cell = x * MAX_GRID_Y + y;
+        for (uint32_t i = cell_start[cell]; i < cell_start[cell + 1]; ++i)
+            out.push_back({ entries[i].id, entries[i].x, entries[i].y });
+        for (uint32_t i = static_cell_start[cell]; i < static_cell_start[cell + 1]; ++i)
+            out.push_back({ static_entries[i].id, static_entries[i].x, static_entries[i].y });
+    });
 }
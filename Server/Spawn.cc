@@ -14,15 +14,15 @@ Entity &alloc_drop(Simulation *sim, PetalID::T drop_id) {
     DEBUG_ONLY(assert(drop_id < PetalID::kNumPetals);)
     PetalTracker::add_petal(sim, drop_id);
     Entity &drop = sim->alloc_ent();
-    drop.add_component(kPhysics);
+    sim->add_component(drop, kPhysics);
     drop.set_radius(25);
     drop.set_angle(frand() * 0.2 - 0.1);
     drop.friction = 0.25;
 
-    drop.add_component(kRelations);
+    sim->add_component(drop, kRelations);
     drop.set_team(NULL_ENTITY);
 
-    drop.add_component(kDrop);
+    sim->add_component(drop, kDrop);
     drop.set_drop_id(drop_id);
     entity_set_despawn_tick(drop, 10 * (2 + PETAL_DATA[drop_id].rarity) * TPS);
     drop.immunity_ticks = TPS / 3;
@@ -35,7 +35,7 @@ static Entity &__alloc_mob(Simulation *sim, MobID::T mob_id, float x, float y, E
     float seed = frand();
     Entity &mob = sim->alloc_ent();
 
-    mob.add_component(kPhysics);
+    sim->add_component(mob, kPhysics);
     mob.set_radius(data.radius.get_single(seed));
     mob.set_angle(frand() * 2 * M_PI);
     mob.set_x(x);
@@ -47,13 +47,13 @@ static Entity &__alloc_mob(Simulation *sim, MobID::T mob_id, float x, float y, E
     if (team == NULL_ENTITY)
         BitMath::set(mob.flags, EntityFlags::kHasCulling);
         
-    mob.add_component(kRelations);
+    sim->add_component(mob, kRelations);
     mob.set_team(team);
 
-    mob.add_component(kMob);
+    sim->add_component(mob, kMob);
     mob.set_mob_id(mob_id);
 
-    mob.add_component(kHealth);
+    sim->add_component(mob, kHealth);
     mob.health = mob.max_health = data.health.get_single(seed);
     mob.damage = data.damage;
     mob.poison_damage = data.attributes.poison_damage;
@@ -62,12 +62,12 @@ static Entity &__alloc_mob(Simulation *sim, MobID::T mob_id, float x, float y, E
     mob.detection_radius = data.attributes.aggro_radius;
     mob.score_reward = data.xp;
 
-    mob.add_component(kName);
+    sim->add_component(mob, kName);
     mob.set_name(data.name);
 
     mob.base_entity = mob.id;
     if (mob_id == MobID::kDigger) {
-        mob.add_component(kFlower);
+        sim->add_component(mob, kFlower);
         mob.set_angle(0);
         mob.set_color(ColorID::kGray);
     }
@@ -93,11 +93,11 @@ Entity &alloc_mob(Simulation *sim, MobID::T mob_id, float x, float y, EntityID c
     }
     else {
         Entity &head = __alloc_mob(sim, mob_id, x, y, team);
-        //head.add_component(kSegmented);
+        //sim->add_component(head, kSegmented);
         Entity *curr = &head;
         for (uint32_t i = 1; i < data.attributes.segments; ++i) {
             Entity &seg = __alloc_mob(sim, mob_id, x, y, team);
-            seg.add_component(kSegmented);
+            sim->add_component(seg, kSegmented);
             seg.seg_head = curr->id;
             seg.set_angle(curr->get_angle() + frand() * 0.1 - 0.05);
             seg.set_x(curr->get_x() - (curr->get_radius() + seg.get_radius()) * cosf(seg.get_angle()));
@@ -111,25 +111,25 @@ Entity &alloc_mob(Simulation *sim, MobID::T mob_id, float x, float y, EntityID c
 Entity &alloc_player(Simulation *sim, EntityID const team) {
     Entity &player = sim->alloc_ent();
 
-    player.add_component(kPhysics);
+    sim->add_component(player, kPhysics);
     player.set_radius(BASE_FLOWER_RADIUS);
     player.friction = DEFAULT_FRICTION;
     player.mass = 1;
 
-    player.add_component(kFlower);
+    sim->add_component(player, kFlower);
 
-    player.add_component(kRelations);
+    sim->add_component(player, kRelations);
     player.set_team(team);
 
-    player.add_component(kHealth);
+    sim->add_component(player, kHealth);
     player.health = player.max_health = BASE_HEALTH;
     player.set_health_ratio(1);
     player.damage = BASE_BODY_DAMAGE;
     player.immunity_ticks = 1.0 * TPS;
 
-    player.add_component(kScore);
+    sim->add_component(player, kScore);
 
-    player.add_component(kName);
+    sim->add_component(player, kName);
     player.set_nametag_visible(1);
 
     player.base_entity = player.id;
@@ -140,7 +140,7 @@ Entity &alloc_petal(Simulation *sim, PetalID::T petal_id, Entity const &parent)
     DEBUG_ONLY(assert(petal_id < PetalID::kNumPetals);)
     struct PetalData const &petal_data = PETAL_DATA[petal_id];
     Entity &petal = sim->alloc_ent();
-    petal.add_component(kPhysics);
+    sim->add_component(petal, kPhysics);
     petal.set_x(parent.get_x());
     petal.set_y(parent.get_y());
     petal.set_radius(petal_data.radius);
@@ -148,13 +148,13 @@ Entity &alloc_petal(Simulation *sim, PetalID::T petal_id, Entity const &parent)
         petal.set_angle(frand() * 2 * M_PI);
     petal.mass = petal_data.attributes.mass;
     petal.friction = DEFAULT_FRICTION * 1.5;
-    petal.add_component(kRelations);
+    sim->add_component(petal, kRelations);
     petal.set_parent(parent.id);
     petal.set_team(parent.get_team());
     petal.set_color(parent.get_color());
-    petal.add_component(kPetal);
+    sim->add_component(petal, kPetal);
     petal.set_petal_id(petal_id);
-    petal.add_component(kHealth);
+    sim->add_component(petal, kHealth);
     petal.health = petal.max_health = petal_data.health;
     petal.damage = petal_data.damage;
     petal.set_health_ratio(1);
@@ -169,18 +169,18 @@ Entity &alloc_petal(Simulation *sim, PetalID::T petal_id, Entity const &parent)
 
 Entity &alloc_web(Simulation *sim, float radius, Entity const &parent) {
     Entity &web = sim->alloc_ent();
-    web.add_component(kPhysics);
+    sim->add_component(web, kPhysics);
     web.set_x(parent.get_x());
     web.set_y(parent.get_y());
     web.set_angle(frand() * 2 * M_PI);
     web.set_radius(radius);
     web.mass = 1.0;
     web.friction = 1.0;
-    web.add_component(kRelations);
+    sim->add_component(web, kRelations);
     web.set_team(parent.get_team());
     web.set_parent(parent.id);
     web.set_color(parent.get_color());
-    web.add_component(kWeb);
+    sim->add_component(web, kWeb);
     entity_set_despawn_tick(web, 10 * TPS);
     return web;
 }
@@ -202,7 +202,7 @@ void player_spawn(Simulation *sim, Entity &camera, Entity &player) {
     player.health = player.max_health = hp_at_level(camera.get_respawn_level());
     for (uint32_t i = 0; i < player.get_loadout_count(); ++i) {
         PetalID::T id = camera.get_inventory(i);
-        LoadoutSlot &slot = player.loadout[i];
+        LoadoutSlot &slot = sim->get_flower_data(player).loadout[i];
         player.set_loadout_ids(i, id);
         slot.update_id(sim, id);
         slot.force_reload();
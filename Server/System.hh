@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+
+class Simulation;
+class Entity;
+
+//groups of entity state, for declaring what a System touches
+namespace Access {
+    enum : uint32_t {
+        //x, y, radius
+        kPosition = 1 << 0,
+        //angle, velocity, acceleration and the rest of the motion state
+        kMotion = 1 << 1,
+        //target, parent, ai state and input
+        kBehavior = 1 << 2,
+        //what ent_alive looks at: existence, pending_delete, deletion_tick
+        kLifecycle = 1 << 3,
+        //score, score_reward
+        kScore = 1 << 4,
+        //writes entities other than its own, or allocs or deletes directly
+        kExclusive = 1 << 5
+    };
+}
+
+//one per-entity pass of a tick, and what it touches
+//reads may be of any entity, writes only of the entity it is called on
+//anything else the system changes goes through Simulation::commands()
+struct System {
+    void (*tick)(Simulation *, Entity &);
+    //runs on entities with every one of these components
+    uint32_t with;
+    uint32_t reads;
+    uint32_t writes;
+    //nothing it writes is read across entities, so it can run on many entities at once
+    constexpr bool parallel() const {
+        return !(writes & Access::kExclusive) && (writes & reads) == 0;
+    }
+    //one of them writes something the other touches
+    constexpr bool conflicts(System const &other) const {
+        if ((writes | other.writes) & Access::kExclusive) return true;
+        return (writes & (other.reads | other.writes)) != 0 || (other.writes & reads) != 0;
+    }
+};
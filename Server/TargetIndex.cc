@@ -0,0 +1,95 @@
+#include <Server/TargetIndex.hh>
+
+#include <Server/SpatialHash.hh>
+#include <Shared/Simulation.hh>
+#include <Shared/Entity.hh>
+
+#include <algorithm>
+
+static uint32_t _cell_x(float x) {
+    return fclamp(x, 0, ARENA_WIDTH - 1) / TARGET_CELL_SIZE;
+}
+
+static uint32_t _cell_y(float y) {
+    return fclamp(y, 0, ARENA_HEIGHT - 1) / TARGET_CELL_SIZE;
+}
+
+static uint32_t _cell_of(TargetEntry const &entry) {
+    return _cell_x(entry.x) * TARGET_GRID_Y + _cell_y(entry.y);
+}
+
+//same counting sort as the uniform spatial hash
+static void _counting_sort(TargetGroup &group) {
+    uint32_t const num_cells = TARGET_GRID_X * TARGET_GRID_Y;
+    std::vector<uint32_t> &cell_start = group.cell_start;
+    cell_start.assign(num_cells + 1, 0);
+    for (TargetEntry const &entry : group.pending)
+        ++cell_start[_cell_of(entry) + 1];
+    for (uint32_t c = 0; c < num_cells; ++c)
+        cell_start[c + 1] += cell_start[c];
+    group.entries.resize(group.pending.size());
+    //cell_start[c] is used as the write cursor for cell c, and ends up where cell c + 1 starts
+    for (TargetEntry const &entry : group.pending)
+        group.entries[cell_start[_cell_of(entry)]++] = entry;
+    for (uint32_t c = num_cells; c > 0; --c)
+        cell_start[c] = cell_start[c - 1];
+    cell_start[0] = 0;
+}
+
+TargetIndex::TargetIndex(Simulation *sim) : simulation(sim) {}
+
+void TargetIndex::begin_tick() {
+    neutral.pending.clear();
+    teamed.pending.clear();
+}
+
+void TargetIndex::insert(Entity const &ent) {
+    TargetGroup &group = ent.get_team() == NULL_ENTITY ? neutral : teamed;
+    group.pending.push_back({ ent.get_x(), ent.get_y(), ent.id, ent.get_team() });
+}
+
+void TargetIndex::build() {
+    for (TargetGroup *group : { &neutral, &teamed }) {
+        group->pending.erase(std::remove_if(group->pending.begin(), group->pending.end(), [&](TargetEntry const &entry) {
+            return !simulation->ent_alive(entry.id) || simulation->get_ent(entry.id).immunity_ticks > 0;
+        }), group->pending.end());
+        _counting_sort(*group);
+    }
+}
+
+EntityID TargetIndex::nearest_enemy(Entity const &entity, float radius, float &best_dist) const {
+    float const x = entity.get_x(), y = entity.get_y();
+    EntityID const team = entity.get_team();
+    //summoned mobs only take targets within SUMMON_RETREAT_RADIUS of their parent
+    uint8_t const has_parent = simulation->ent_alive(entity.get_parent());
+    float px = 0, py = 0;
+    if (has_parent) {
+        Entity const &parent = simulation->get_ent(entity.get_parent());
+        px = parent.get_x();
+        py = parent.get_y();
+    }
+    EntityID best;
+    best_dist = radius;
+    auto search = [&](TargetGroup const &group, uint32_t cell) {
+        for (uint32_t i = group.cell_start[cell]; i < group.cell_start[cell + 1]; ++i) {
+            TargetEntry const &entry = group.entries[i];
+            float dist = Vector(entry.x - x, entry.y - y).magnitude();
+            if (dist >= best_dist) continue;
+            if (entry.team == team) continue;
+            if (has_parent && Vector(entry.x - px, entry.y - py).magnitude() > SUMMON_RETREAT_RADIUS) continue;
+            //can be deleted after build, ie. during tick_ai_behavior
+            if (!simulation->ent_alive(entry.id)) continue;
+            best_dist = dist;
+            best = entry.id;
+        }
+    };
+    //the same ring by ring search as SpatialHash::nearest, over this index's cells
+    for_each_ring(x, y, TARGET_CELL_SIZE, TARGET_GRID_X, TARGET_GRID_Y, best_dist, [&](uint32_t cx, uint32_t cy, uint32_t ring) {
+        for_each_ring_cell(cx, cy, ring, TARGET_GRID_X, TARGET_GRID_Y, [&](uint32_t cell_x, uint32_t cell_y) {
+            uint32_t const cell = cell_x * TARGET_GRID_Y + cell_y;
+            if (!(team == NULL_ENTITY)) search(neutral, cell);
+            search(teamed, cell);
+        });
+    });
+    return best;
+}
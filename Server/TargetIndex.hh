@@ -0,0 +1,49 @@
+#pragma once
+
+#include <Shared/Entity.hh>
+#include <Shared/StaticData.hh>
+
+#include <cstdint>
+#include <vector>
+
+class Simulation;
+class Entity;
+
+//coarser than the spatial hash, since searches reach up to detection_radius (600-750)
+static const uint32_t TARGET_CELL_SIZE = 800;
+static const uint32_t TARGET_GRID_X = div_round_up(ARENA_WIDTH, TARGET_CELL_SIZE);
+static const uint32_t TARGET_GRID_Y = div_round_up(ARENA_HEIGHT, TARGET_CELL_SIZE);
+
+struct TargetEntry {
+    float x;
+    float y;
+    EntityID id;
+    EntityID team;
+};
+
+//cell c = x * TARGET_GRID_Y + y holds entries[cell_start[c], cell_start[c + 1])
+struct TargetGroup {
+    std::vector<TargetEntry> pending;
+    std::vector<TargetEntry> entries;
+    std::vector<uint32_t> cell_start;
+};
+
+//everything a mob can target (mobs and flowers), split into the mobs without a team and
+//everything on a team (flowers and what they summoned), so the mobs without a team,
+//nearly all of them, only search the few entities on teams. a group per team would
+//mean a group per player outside of GAMEMODE_TDM.
+//rebuilt every tick, positions are as of insert
+class TargetIndex {
+    Simulation *simulation;
+    TargetGroup neutral;
+    TargetGroup teamed;
+public:
+    TargetIndex(Simulation *);
+    void begin_tick();
+    void insert(Entity const &);
+    //drops what died or became immune since insert and sorts the rest by cell
+    void build();
+    //the nearest living entity of another team strictly closer than radius, with
+    //entity's parent rule applied, and how far it is. safe to call from several threads
+    EntityID nearest_enemy(Entity const &, float, float &) const;
+};
@@ -0,0 +1,88 @@
+#include <Shared/Map.hh>
+#include <Shared/Simulation.hh>
+
+#include <Server/Client.hh>
+#include <Server/Scheduler.hh>
+#include <Server/Server.hh>
+#include <Server/Spawn.hh>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+//times Simulation ticks on a mob-filled arena (gardn-tick-bench target)
+//usage: gardn-tick-bench [entity capacity] [threads, 0 for one per core] [ticks] [entities] [players]
+//with [entities], the arena is topped up past its zone densities with zone mobs until that
+//many entities are alive (eg. 32768 at a capacity of 65536 for a stress run)
+//mobs out of every player's view skip their ai, so without [players] (clients without a socket,
+//scattered over the arena) the ai hardly runs
+//the seed is fixed, so runs with different thread counts simulate the same ticks and
+//print the same checksum of the final entity state
+
+int main(int argc, char **argv) {
+    uint32_t entity_cap = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : DEFAULT_ENTITY_CAP;
+    uint32_t threads = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 0;
+    uint32_t ticks = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 10 * TPS;
+    uint32_t entities = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 0;
+    uint32_t players = argc > 5 ? std::strtoul(argv[5], nullptr, 10) : 0;
+    Scheduler::init(threads);
+    seed_frand(0);
+    Simulation *sim = &Server::game.simulation;
+    sim->set_capacity(entity_cap);
+    Server::game.init();
+    auto live_count = [&]() {
+        uint32_t count = 0;
+        sim->for_each_entity([&](Simulation *, Entity &) { ++count; });
+        return count;
+    };
+    //ticks in between so the new mobs count as alive at the start of a tick
+    while (live_count() < entities) {
+        for (uint32_t i = 0; i < 64; ++i) {
+            float x = frand() * ARENA_WIDTH, y = frand() * ARENA_HEIGHT;
+            alloc_mob(sim, Map::random_zone_mob(Map::get_zone_from_pos(x, y)), x, y, NULL_ENTITY);
+        }
+        sim->tick();
+        sim->post_tick();
+    }
+    for (uint32_t i = 0; i < players; ++i) {
+        Client *client = new Client();
+        client->ws = nullptr;
+        client->verified = 1;
+        Server::game.add_client(client);
+        Entity &camera = sim->get_ent(client->camera);
+        Entity &player = alloc_player(sim, camera.get_team());
+        player_spawn(sim, camera, player);
+        player.set_x(frand() * ARENA_WIDTH);
+        player.set_y(frand() * ARENA_HEIGHT);
+        camera.set_camera_x(player.get_x());
+        camera.set_camera_y(player.get_y());
+    }
+    //let the arena settle before timing
+    for (uint32_t i = 0; i < TPS; ++i) {
+        sim->tick();
+        sim->post_tick();
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < ticks; ++i) {
+        sim->tick();
+        sim->post_tick();
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "Threads: " << Scheduler::thread_count() << '\n';
+    std::cout << "Entity Capacity: " << sim->capacity() << '\n';
+    std::cout << "Entities: " << live_count() << '\n';
+    std::cout << "Ticks: " << ticks << '\n';
+    std::cout << "ms/tick: " << elapsed.count() / ticks << '\n';
+    uint64_t checksum = 0;
+    sim->for_each<kPhysics>([&](Simulation *, Entity &ent) {
+        float const state[] = { ent.get_x(), ent.get_y(), ent.get_angle(), ent.health };
+        for (float v : state) {
+            uint32_t bits;
+            std::memcpy(&bits, &v, sizeof(bits));
+            checksum = (checksum ^ bits ^ ent.id.id) * 1099511628211ull;
+        }
+    });
+    std::cout << "Checksum: " << std::hex << checksum << std::dec << '\n';
+    return 0;
+}
@@ -3,13 +3,38 @@
 #include <Helpers/Bits.hh>
 #include <Helpers/UTF8.hh>
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
 static const uint32_t PROTOCOL_FLOAT_SCALE = 64;
 
 
-Writer::Writer(uint8_t *v) : at(v), packet(v) {}
+Writer::Writer(uint8_t *v, uint32_t capacity) : buffer(nullptr), at(v), packet(v), end(v + capacity) {}
+
+Writer::Writer(std::vector<uint8_t> &v, uint32_t offset) : buffer(&v), at(v.data() + offset), 
+    packet(at), end(v.data() + v.size()) {}
 
-void Writer::push(uint8_t val) {
-    *at++ = val;
+void Writer::_reserve(uint32_t len) {
+    if (buffer == nullptr) {
+        std::cerr << "Writer: packet overflow (" << (at - packet) + len 
+            << " bytes, capacity " << end - packet << ")\n";
+        std::abort();
+    }
+    uint32_t const offset = packet - buffer->data();
+    uint32_t const length = at - packet;
+    //at least a 4 KiB jump, so a fresh buffer is not regrown byte by byte
+    buffer->resize(std::max<size_t>(2 * buffer->size(), offset + length + len + 4096));
+    packet = buffer->data() + offset;
+    at = packet + length;
+    end = buffer->data() + buffer->size();
+}
+
+void Writer::push(uint8_t const *bytes, uint32_t len) {
+    if ((uint32_t) (end - at) < len) _reserve(len);
+    std::memcpy(at, bytes, len);
+    at += len;
 }
 
 template<>
@@ -8,7 +8,8 @@
 
 
 enum Clientbound {
-    kClientUpdate
+    kClientUpdate,
+    kServerInfo
 };
 
 enum Serverbound {
@@ -25,10 +26,15 @@ enum CloseReason {
     kOutdated = 4003
 };
 
+//writes into a fixed buffer, which must never overflow, or into a vector from an
+//offset, which grows as needed. a grow moves at and packet, so keep offsets, not pointers
 class Writer {
+    std::vector<uint8_t> *buffer;
+    void _reserve(uint32_t);
 public:
     uint8_t *at;
     uint8_t *packet;
+    uint8_t *end;
     template<typename T>
     class Encoder {
         friend class Writer;
@@ -44,12 +50,19 @@ public:
         };
     };
 
-    Writer(uint8_t *);
+    Writer(uint8_t *, uint32_t);
+    Writer(std::vector<uint8_t> &, uint32_t);
     template<typename T>
     void write(T const &v) {
         Encoder<T>::write(*this, v);
     };
-    void push(uint8_t);
+    void push(uint8_t val) {
+        if (at == end) [[unlikely]] _reserve(1);
+        *at++ = val;
+    };
+    //bytes another Writer already encoded
+    void push(uint8_t const *, uint32_t);
+    uint32_t size() const { return at - packet; };
 };
 
 class Reader {
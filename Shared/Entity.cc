@@ -3,7 +3,21 @@
 #include <Shared/Binary.hh>
 #include <Shared/StaticData.hh>
 
-#include <Shared/Binary.hh>
+#include <cmath>
+
+using namespace EntityWire;
+
+#ifdef SERVERSIDE
+//wire_x and wire_y are the position every client that has the entity holds, the base of
+//its position changes. reset_protocol() keeps them current from the entity's first
+//post_tick on. until then (lifetime 0, which covers a whole tick for anything allocated
+//mid-tick, since post_tick skips it) set_x and set_y keep them equal to what a create
+//would carry. a change is only ever written once a post_tick has run, because a client
+//can only have been sent the create in an earlier tick (write<false> asserts it)
+static int32_t _position_to_wire(float v) {
+    return std::lround(v * POSITION_SCALE);
+}
+#endif
 
 Entity::Entity() {
     init();
@@ -33,6 +47,12 @@ void Entity::reset_protocol() {
     PERFIELD
     #undef SINGLE
     #undef MULTIPLE
+    #ifdef SERVERSIDE
+    //what every client has for this tick, the base of next tick's position changes
+    //(see _position_to_wire)
+    wire_x = _position_to_wire(x);
+    wire_y = _position_to_wire(y);
+    #endif
 }
 
 void Entity::add_component(uint32_t comp) {
@@ -65,6 +85,10 @@ void Entity::set_##name(type const &v) { \
     if (name == v) return; \
     name = v; \
     BitMath::set_arr(state, k##name); \
+    if constexpr (k##name == kx || k##name == ky || k##name == kradius || k##name == kteam) \
+        spatial_dirty = 1; \
+    if constexpr (k##name == kx) { if (lifetime == 0) wire_x = _position_to_wire(x); } \
+    if constexpr (k##name == ky) { if (lifetime == 0) wire_y = _position_to_wire(y); } \
 }
 #define MULTIPLE(component, name, type, amt) \
 void Entity::set_##name(uint32_t i, type const &v) { \
@@ -78,11 +102,25 @@ PERFIELD
 #undef SINGLE
 #undef MULTIPLE
 
+template<uint32_t field, typename T>
+void Entity::write_field(Writer *writer, T const &v, uint8_t create) const {
+    if constexpr (field == kangle)
+        writer->write<uint8_t>((uint8_t) (int32_t) std::lround(v * ANGLE_SCALE));
+    else if constexpr (field == khealth_ratio)
+        writer->write<uint8_t>((uint8_t) (fclamp(v, 0, 1) * RATIO_SCALE));
+    else if constexpr (field == kx || field == ky) {
+        int32_t const base = create ? 0 : (field == kx ? wire_x : wire_y);
+        writer->write<int32_t>(_position_to_wire(v) - base);
+    }
+    else
+        writer->write<T>(v);
+}
+
 template<>
 void Entity::write<true>(Writer *writer) {
     writer->write<uint32_t>(components);
     writer->write<uint32_t>(lifetime);
-    #define SINGLE(component, name, type) { writer->write<type>(name); }
+    #define SINGLE(component, name, type) { write_field<k##name>(writer, name, 1); }
     #define MULTIPLE(component, name, type, amt) { \
         for (uint32_t n = 0; n < amt; ++n) \
             writer->write<type>(name[n]); \
@@ -96,10 +134,12 @@ void Entity::write<true>(Writer *writer) {
 
 template<>
 void Entity::write<false>(Writer *writer) {
+    //see _position_to_wire
+    DEBUG_ONLY(assert(lifetime > 0);)
     #define SINGLE(component, name, type) \
         if(BitMath::at_arr(state, k##name)) { \
             writer->write<uint8_t>(k##name); \
-            writer->write<type>(name); \
+            write_field<k##name>(writer, name, 0); \
     }
     #define MULTIPLE(component, name, type, amt) \
         if(BitMath::at_arr(state, k##name)) { \
@@ -126,11 +166,27 @@ void Entity::write(Writer *writer, uint8_t create) {
 }
 #else
 
+template<uint32_t field, typename T>
+void Entity::read_field(Reader *reader, T &v, uint8_t create) {
+    if constexpr (field == kangle)
+        v.set(reader->read<uint8_t>() / ANGLE_SCALE);
+    else if constexpr (field == khealth_ratio)
+        v.set(reader->read<uint8_t>() / RATIO_SCALE);
+    else if constexpr (field == kx || field == ky) {
+        int32_t &wire = field == kx ? wire_x : wire_y;
+        if (create) wire = 0;
+        wire += reader->read<int32_t>();
+        v.set(wire / POSITION_SCALE);
+    }
+    else
+        reader->read<T>(v);
+}
+
 template<>
 void Entity::read<true>(Reader *reader) {
     components = reader->read<uint32_t>();
     lifetime = reader->read<uint32_t>();
-    #define SINGLE(component, name, type) { reader->read<type>(name); BitMath::set_arr(state, k##name); }
+    #define SINGLE(component, name, type) { read_field<k##name>(reader, name, 1); BitMath::set_arr(state, k##name); }
     #define MULTIPLE(component, name, type, amt) { \
         BitMath::set_arr(state, k##name); \
         for (uint32_t n = 0; n < amt; ++n) { \
@@ -152,7 +208,7 @@ void Entity::read<false>(Reader *reader) {
         switch(reader->read<uint8_t>()) {
             case kFieldCount: { return; }
             #define SINGLE(component, name, type) case k##name: { \
-                reader->read<type>(name); \
+                read_field<k##name>(reader, name, 0); \
                 BitMath::set_arr(state, k##name); \
                 break; \
             }
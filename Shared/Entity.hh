@@ -5,12 +5,21 @@
 #include <Helpers/Array.hh>
 #include <Helpers/Bits.hh>
 #include <Helpers/Macros.hh>
+#include <Helpers/Math.hh>
 #include <Helpers/Vector.hh>
 
 #include <cstdint>
 
 typedef CircularArray<PetalID::T, MAX_SLOT_COUNT> circ_arr_t;
 
+#ifdef SERVERSIDE
+//server state only flowers have, kept out of Entity (see Simulation::get_flower_data)
+struct FlowerData {
+    LoadoutSlot loadout[MAX_SLOT_COUNT];
+    circ_arr_t deleted_petals;
+};
+#endif
+
 SERVER_ONLY(class Writer;)
 CLIENT_ONLY(class Reader;)
 
@@ -27,7 +36,22 @@ enum Components {
     kComponentCount
 };
 
+//wire formats for fields that do not need a plain Float's 1/64 precision. angles go as a
+//byte of a turn and health ratios as a byte. positions go as whole 1/64 units when an
+//entity is created and, after that, as the change since the tick before. every client that
+//has the entity was sent every change, so the change is the same for all of them
+namespace EntityWire {
+    inline float const POSITION_SCALE = 64;
+    inline float const ANGLE_SCALE = 256 / (2 * M_PI);
+    inline float const RATIO_SCALE = 255;
+}
+
+//bitmask of the given components, for use in component queries
+template<typename ...Comps>
+constexpr uint32_t component_mask(Comps ...comps) { return ((1u << comps) | ... | 0u); }
+
 class Entity {
+    friend class Simulation;
     enum Fields {
         #define SINGLE(component, name, type) k##name,
         #define MULTIPLE(component, name, type, amt) k##name,
@@ -37,12 +61,46 @@ class Entity {
         kFieldCount
     };
     uint32_t components;
+    //use Simulation::add_component, which also keeps the component index up to date
+    void add_component(uint32_t);
+#ifdef DECLARED_ENTITY_LAYOUT
+    //declaration order, for comparing against the split below (see gardn-layout-bench)
 #define SINGLE(component, name, type) type name;
 #define MULTIPLE(component, name, type, amt) type name[amt];
     PERFIELD
 #undef SINGLE
 #undef MULTIPLE
     uint8_t state[div_round_up(kFieldCount, 8)];
+#else
+    //per-tick fields first (see PERFIELD_HOT), with the state bits their setters write,
+    //the rest of the entity after
+#define SINGLE(component, name, type) type name;
+#define MULTIPLE(component, name, type, amt) type name[amt];
+    PERFIELD_HOT
+#undef SINGLE
+#undef MULTIPLE
+    uint8_t state[div_round_up(kFieldCount, 8)];
+public:
+    EntityID id;
+    uint8_t pending_delete;
+#define SINGLE(name, type, reset) type name;
+#define MULTIPLE(name, type, amt, reset) type name[amt];
+    PER_EXTRA_FIELD_HOT
+#undef SINGLE
+#undef MULTIPLE
+private:
+#define SINGLE(component, name, type) type name;
+#define MULTIPLE(component, name, type, amt) type name[amt];
+    PERFIELD_COLD
+#undef SINGLE
+#undef MULTIPLE
+    //a duplicate would not compile, so equal counts means the split covers PERFIELD
+#define SINGLE(component, name, type) +1
+#define MULTIPLE(component, name, type, amt) +1
+    static_assert(0 PERFIELD_HOT PERFIELD_COLD == kFieldCount);
+#undef SINGLE
+#undef MULTIPLE
+#endif
 #define SINGLE(component, name, type);
 #define MULTIPLE(component, name, type, amt) uint8_t state_per_##name[div_round_up(amt, 8)];
     PERFIELD
@@ -56,9 +114,6 @@ public:
     Entity &operator=(Entity const &) = delete;
     Entity &operator=(Entity &&) = delete;
     uint32_t lifetime;
-    EntityID id;
-    uint8_t pending_delete;
-    void add_component(uint32_t);
     uint8_t has_component(uint32_t) const;
 
 #define SINGLE(component, name, type) type const &get_##name() const;
@@ -67,17 +122,30 @@ public:
 #undef SINGLE
 #undef MULTIPLE
 
+#ifdef DECLARED_ENTITY_LAYOUT
+    EntityID id;
+    uint8_t pending_delete;
 #define SINGLE(name, type, reset) type name;
 #define MULTIPLE(name, type, amt, reset) type name[amt];
     PER_EXTRA_FIELD
 #undef SINGLE
 #undef MULTIPLE
+#else
+#define SINGLE(name, type, reset) type name;
+#define MULTIPLE(name, type, amt, reset) type name[amt];
+    PER_EXTRA_FIELD_COLD
+#undef SINGLE
+#undef MULTIPLE
+#endif
 
 #ifdef SERVERSIDE
     void write(Writer *, uint8_t);
 
     template<bool>
     void write(Writer *);
+    //one field in its wire format (see Entity.cc)
+    template<uint32_t, typename T>
+    void write_field(Writer *, T const &, uint8_t) const;
 #define SINGLE(component, name, type) void set_##name(type const &);
 #define MULTIPLE(component, name, type, amt) void set_##name(uint32_t, type const &);
     PERFIELD
@@ -89,6 +157,8 @@ public:
 
     template<bool>
     void read(Reader *);
+    template<uint32_t, typename T>
+    void read_field(Reader *, T &, uint8_t);
 
     #define SINGLE(component, name, type) uint8_t get_state_##name() const;
     #define MULTIPLE(component, name, type, amt) uint8_t get_state_##name(uint32_t) const;
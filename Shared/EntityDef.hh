@@ -33,6 +33,24 @@ FIELDS_Segmented \
 FIELDS_Score \
 FIELDS_Name
 
+//PERFIELD split by access pattern, only used for Entity member layout
+//(wire field ids follow PERFIELD order). fields read by motion and
+//collision every tick go first so they share as few cache lines as possible
+#define PERFIELD_HOT \
+FIELDS_Physics \
+FIELDS_Relations
+
+#define PERFIELD_COLD \
+FIELDS_Camera \
+FIELDS_Flower \
+FIELDS_Petal \
+FIELDS_Health \
+FIELDS_Mob \
+FIELDS_Drop \
+FIELDS_Segmented \
+FIELDS_Score \
+FIELDS_Name
+
 #define FIELDS_Physics \
 SINGLE(Physics, x, Float) \
 SINGLE(Physics, y, Float) \
@@ -86,20 +104,25 @@ SINGLE(Name, name, std::string) \
 SINGLE(Name, nametag_visible, uint8_t)
 
 #ifdef SERVERSIDE
-#define PER_EXTRA_FIELD \
+#define PER_EXTRA_FIELD_HOT \
     SINGLE(velocity, Vector, .set(0,0)) \
     SINGLE(collision_velocity, Vector, .set(0,0)) \
     SINGLE(acceleration, Vector, .set(0,0)) \
     SINGLE(friction, float, =0) \
     SINGLE(mass, float, =1) \
     SINGLE(speed_ratio, float, =1) \
-    \
-    MULTIPLE(loadout, LoadoutSlot, MAX_SLOT_COUNT, .reset()) \
+    SINGLE(health, float, =0) \
+    SINGLE(damage, float, =0) \
+    SINGLE(slow_ticks, game_tick_t, =0) \
+    SINGLE(flags, uint8_t, =0) \
+    SINGLE(spatial_dirty, uint8_t, =0)
+
+#define PER_EXTRA_FIELD_COLD \
     SINGLE(heading_angle, float, =0) \
+    SINGLE(parent_acceleration, Vector, .set(0,0)) \
     SINGLE(input, uint8_t, =0) \
     SINGLE(player_count, uint32_t, =0) \
     \
-    SINGLE(slow_ticks, game_tick_t, =0) \
     SINGLE(slow_inflict, game_tick_t, =0) \
     SINGLE(immunity_ticks, game_tick_t, =0) \
     SINGLE(dandy_ticks, game_tick_t, =0) \
@@ -107,9 +130,7 @@ SINGLE(Name, nametag_visible, uint8_t)
     SINGLE(poison_inflicted, float, =0) \
     SINGLE(poison_dealer, EntityID, =NULL_ENTITY) \
     SINGLE(poison_damage, PoisonDamage, ={}) \
-    SINGLE(health, float, =0) \
     SINGLE(max_health, float, =0) \
-    SINGLE(damage, float, =0) \
     SINGLE(armor, float, =0) \
     SINGLE(poison_armor, float, =0) \
     SINGLE(damage_reflection, float, =0) \
@@ -122,15 +143,21 @@ SINGLE(Name, nametag_visible, uint8_t)
     SINGLE(detection_radius, float, =0) \
     SINGLE(ai_tick, game_tick_t, =0) \
     SINGLE(ai_state, uint8_t, =0) \
+    SINGLE(acquired_target, EntityID, =NULL_ENTITY) \
+    SINGLE(acquired_dist, float, =0) \
+    SINGLE(acquired_radius, float, =0) \
     \
     SINGLE(zone, uint8_t, =0) \
-    SINGLE(flags, uint8_t, =0) \
     SINGLE(deletion_tick, uint8_t, =0) \
     SINGLE(despawn_tick, game_tick_t, =0) \
     SINGLE(secondary_reload, game_tick_t, =0) \
-    SINGLE(deleted_petals, circ_arr_t, ={})
+    \
+    SINGLE(wire_x, int32_t, =0) \
+    SINGLE(wire_y, int32_t, =0)
 #else
-#define PER_EXTRA_FIELD \
+#define PER_EXTRA_FIELD_HOT
+
+#define PER_EXTRA_FIELD_COLD \
     SINGLE(last_damaged_time, double, =0) \
     SINGLE(healthbar_lag, float, =0) \
     SINGLE(healthbar_opacity, float, =0) \
@@ -139,18 +166,28 @@ SINGLE(Name, nametag_visible, uint8_t)
     SINGLE(eye_y, float, =0) \
     SINGLE(mouth, float, =15) \
     SINGLE(animation, float, =0) \
-    SINGLE(damage_flash, float, =0)
+    SINGLE(damage_flash, float, =0) \
+    SINGLE(wire_x, int32_t, =0) \
+    SINGLE(wire_y, int32_t, =0)
 #endif
 
+#define PER_EXTRA_FIELD PER_EXTRA_FIELD_HOT PER_EXTRA_FIELD_COLD
+
 class EntityID {
 public:
+#ifdef WIDE_ENTITY_ID
+    //room for very large capacities, and 65536 reuses of a slot before a stale id can match
+    typedef uint16_t hash_type;
+    typedef uint32_t id_type;
+#else
     typedef uint8_t hash_type;
     typedef uint16_t id_type;
+#endif
     id_type id;
     hash_type hash;
     EntityID();
     EntityID(id_type, hash_type);
-    static uint32_t make_hash(EntityID const);
+    static uint64_t make_hash(EntityID const);
     static bool equal_to(EntityID const, EntityID const);
     bool null() const;
 };
@@ -44,29 +44,31 @@ void Map::spawn_random_mob(Simulation *sim, float x, float y) {
     uint32_t zone_id = Map::get_zone_from_pos(x, y);
     struct ZoneDefinition const &zone = MAP_DATA[zone_id];
     if (zone.density * (zone.right - zone.left) * (zone.bottom - zone.top) / (500 * 500) < sim->zone_mob_counts[zone_id]) return;
+    Entity &ent = alloc_mob(sim, random_zone_mob(zone_id), x, y, NULL_ENTITY);
+    ent.zone = zone_id;
+    ent.immunity_ticks = TPS;
+    BitMath::set(ent.flags, EntityFlags::kSpawnedFromZone);
+    sim->zone_mob_counts[zone_id]++;
+}
+
+MobID::T Map::random_zone_mob(uint32_t zone_id) {
+    struct ZoneDefinition const &zone = MAP_DATA[zone_id];
     float sum = 0;
     for (SpawnChance const &s : zone.spawns)
         sum += s.chance;
     sum *= frand();
     for (SpawnChance const &s : zone.spawns) {
         sum -= s.chance;
-        if (sum <= 0) {
-            Entity &ent = alloc_mob(sim, s.id, x, y, NULL_ENTITY);
-            ent.zone = zone_id;
-            ent.immunity_ticks = TPS;
-            BitMath::set(ent.flags, EntityFlags::kSpawnedFromZone);
-            sim->zone_mob_counts[zone_id]++;
-            return;
-        }
+        if (sum <= 0) return s.id;
     }
+    return zone.spawns[zone.spawns.size() - 1].id;
 }
 
 bool Map::find_spawn_location(Simulation *sim, float d, Vector &vref) {
     for (uint32_t i = 0; i < 10; ++i) {
         vref.set(frand() * ARENA_WIDTH, frand() * ARENA_HEIGHT);
         bool valid = true;
-        sim->for_each<kFlower>([&](Simulation *, Entity &ent) {
-            if (ent.has_component(kMob)) return;
+        sim->for_each_matching<component_mask(kFlower), component_mask(kMob)>([&](Simulation *, Entity &ent) {
             if (!valid) return;
             if (Vector(ent.get_x() - vref.x, ent.get_y() - vref.y).magnitude() < d) 
                 valid = false;
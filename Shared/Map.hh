@@ -19,6 +19,8 @@ namespace Map {
     #ifdef SERVERSIDE
     extern void remove_mob(Simulation *, uint32_t);
     extern void spawn_random_mob(Simulation *, float, float);
+    //draws a mob from the zone's spawn chances
+    extern MobID::T random_zone_mob(uint32_t);
     /* finds a spawn location at least <d> units from a player,
     and places it in the Vector &. returns whether or not a
     suitable spawn location was found */ 
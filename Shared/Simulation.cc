@@ -1,5 +1,7 @@
 #include <Shared/Simulation.hh>
 
+#include <algorithm>
+
 #ifdef DEBUG
 #include <iostream>
 
@@ -8,36 +10,104 @@ std::ostream &operator<<(std::ostream &out, EntityID const &id) {
 }
 #endif
 
-Simulation::Simulation() SERVER_ONLY(: spatial_hash(this)) {
+Simulation::Simulation() SERVER_ONLY(: spatial_hash(this), target_index(this)) {
+    set_capacity(DEFAULT_ENTITY_CAP);
+}
+
+void Simulation::set_capacity(uint32_t capacity) {
+    assert(capacity > 0 && capacity <= MAX_ENTITY_CAP);
+    capacity = div_round_up(capacity, 64) * 64;
+    entity_cap = capacity;
+    entity_tracker.assign(capacity / 64, 0);
+    free_word_tracker.assign(div_round_up(capacity / 64, 64), 0);
+    hash_tracker.assign(capacity, 0);
+    for (auto &tracker : component_tracker)
+        tracker.assign(capacity / 64, 0);
+    tick_start_tracker.assign(capacity / 64, 0);
+    entities.reset(new Entity[capacity]);
+    active_entities.clear();
+    active_entities.reserve(capacity);
+    active_index.assign(capacity, 0);
+    SERVER_ONLY(flower_index.assign(capacity, 0);)
     reset();
 }
 
+uint32_t Simulation::capacity() const {
+    return entity_cap;
+}
+
 void Simulation::reset() {
     active_entities.clear();
-    hash_tracker = {0};
-    entity_tracker = {0};
+    active_watermark = 0;
+    active_cursor = 0;
+    std::fill(hash_tracker.begin(), hash_tracker.end(), 0);
+    std::fill(entity_tracker.begin(), entity_tracker.end(), 0);
+    std::fill(free_word_tracker.begin(), free_word_tracker.end(), 0);
+    for (uint32_t word = 0; word < entity_tracker.size(); ++word)
+        BitMath::set_arr(free_word_tracker.data(), word);
+    alloc_cursor = 1;
+    for (auto &tracker : component_tracker)
+        std::fill(tracker.begin(), tracker.end(), 0);
+    std::fill(tick_start_tracker.begin(), tick_start_tracker.end(), 0);
     
-    for (EntityID::id_type i = 0; i < ENTITY_CAP; ++i)
+    for (uint32_t i = 0; i < entity_cap; ++i)
         entities[i].init();
 
     arena_info.init();
     #ifdef SERVERSIDE
+    //one per Scheduler thread, so Scheduler::init has to come first
+    command_buffers.assign(Scheduler::thread_count(), CommandBuffer());
+    merged_commands.clear();
     spatial_hash.refresh(ARENA_WIDTH, ARENA_HEIGHT);
+    flower_data.clear();
+    free_flower_data.clear();
     petal_count_tracker = {0};
     zone_mob_counts = {0};
     #endif
 }
 
+//slot 0 (NULL_ENTITY) is never allocated, so it counts as taken
+void Simulation::_update_free_word(uint32_t word) {
+    if ((entity_tracker[word] | (word == 0)) == ~0ull)
+        BitMath::unset_arr(free_word_tracker.data(), word);
+    else
+        BitMath::set_arr(free_word_tracker.data(), word);
+}
+
+//next-fit over the 64-bit words of entity_tracker: the search resumes after the
+//last allocated slot, so a freed slot is only handed out again once the cursor has
+//swept the rest of the table. stale EntityIDs then need 256 full sweeps (hash_type
+//wraparound) before they can alias a new entity, instead of 256 delete/alloc pairs
+//full words are skipped through free_word_tracker, 64 words (4096 slots) per step
 Entity &Simulation::alloc_ent() {
-    for (EntityID::id_type i = 1; i < ENTITY_CAP; ++i) {
-        if (BitMath::at_arr(entity_tracker.data(), i)) continue;
-        BitMath::set_arr(entity_tracker.data(), i);
-        entities[i].init();
-        DEBUG_ONLY(std::cout << "ent_create " << EntityID(i, hash_tracker[i]) << "\n";)
-        entities[i].id = EntityID(i, hash_tracker[i]);
-        return entities[i];
+    uint32_t const num_words = entity_tracker.size();
+    uint32_t word = alloc_cursor / 64;
+    uint64_t free = ~entity_tracker[word] & (~0ull << (alloc_cursor % 64));
+    if (word == 0) free &= ~1ull;
+    if (free == 0) {
+        //the next word with a free slot, wrapping around to the low bits of the starting word
+        uint32_t const num_summary = free_word_tracker.size();
+        uint32_t next = (word + 1) % num_words;
+        uint32_t summary = next / 64;
+        uint64_t bits = free_word_tracker[summary] & (~0ull << (next % 64));
+        for (uint32_t n = 0; bits == 0 && n < num_summary; ++n) {
+            summary = (summary + 1) % num_summary;
+            bits = free_word_tracker[summary];
+        }
+        assert(bits != 0 && "Entity cap reached");
+        word = summary * 64 + BitMath::ctz(bits);
+        free = ~entity_tracker[word];
+        if (word == 0) free &= ~1ull;
     }
-    assert(!"Entity cap reached");
+    EntityID::id_type i = word * 64 + BitMath::ctz(free);
+    BitMath::set_arr(entity_tracker.data(), i);
+    _update_free_word(word);
+    alloc_cursor = (i + 1) % entity_cap;
+    entities[i].init();
+    DEBUG_ONLY(std::cout << "ent_create " << EntityID(i, hash_tracker[i]) << "\n";)
+    entities[i].id = EntityID(i, hash_tracker[i]);
+    _track_active(i);
+    return entities[i];
 }
 
 Entity &Simulation::get_ent(EntityID const &id) {
@@ -46,17 +116,19 @@ Entity &Simulation::get_ent(EntityID const &id) {
 }
 
 void Simulation::force_alloc_ent(EntityID const &id) {
-    assert(id.id < ENTITY_CAP);
+    assert(id.id < entity_cap);
     DEBUG_ONLY(std::cout << "ent_create " << id << "\n";)
     assert(!BitMath::at_arr(entity_tracker.data(), id.id));
     entities[id.id].init();
     BitMath::set_arr(entity_tracker.data(), id.id);
+    _update_free_word(id.id / 64);
     hash_tracker[id.id] = id.hash;
     entities[id.id].id = id;
+    _track_active(id.id);
 }
 
 uint8_t Simulation::ent_exists(EntityID const &id) const {
-    DEBUG_ONLY(assert(id.id < ENTITY_CAP);)
+    DEBUG_ONLY(assert(id.id < entity_cap);)
     return BitMath::at_arr(entity_tracker.data(), id.id) && hash_tracker[id.id] == id.hash;
 }
 
@@ -65,6 +137,36 @@ uint8_t Simulation::ent_alive(EntityID const &id) const {
     SERVER_ONLY(&& entities[id.id].deletion_tick == 0);
 }
 
+void Simulation::add_component(Entity &ent, uint32_t comp) {
+    ent.add_component(comp);
+    BitMath::set_arr(component_tracker[comp].data(), ent.id.id);
+    #ifdef SERVERSIDE
+    if (comp != kFlower) return;
+    if (free_flower_data.empty()) {
+        flower_index[ent.id.id] = flower_data.size();
+        flower_data.emplace_back();
+    } else {
+        flower_index[ent.id.id] = free_flower_data.back();
+        free_flower_data.pop_back();
+        flower_data[flower_index[ent.id.id]] = {};
+    }
+    #endif
+}
+
+#ifdef SERVERSIDE
+FlowerData &Simulation::get_flower_data(Entity const &ent) {
+    DEBUG_ONLY(assert(ent.has_component(kFlower));)
+    return flower_data[flower_index[ent.id.id]];
+}
+#endif
+
+void Simulation::sync_components(Entity &ent) {
+    for (uint32_t comp = 0; comp < kComponentCount; ++comp) {
+        if (ent.has_component(comp)) BitMath::set_arr(component_tracker[comp].data(), ent.id.id);
+        else BitMath::unset_arr(component_tracker[comp].data(), ent.id.id);
+    }
+}
+
 void Simulation::request_delete(EntityID const &id) {
     DEBUG_ONLY(assert(ent_exists(id)));
     entities[id.id].pending_delete = 1;
@@ -74,35 +176,47 @@ void Simulation::_delete_ent(EntityID const &id) {
     DEBUG_ONLY(std::cout << "ent_delete " << id << "\n";)
     DEBUG_ONLY(assert(ent_exists(id)));
     BitMath::unset_arr(entity_tracker.data(), id.id);
+    BitMath::set_arr(free_word_tracker.data(), id.id / 64);
+    BitMath::unset_arr(tick_start_tracker.data(), id.id);
+    for (uint32_t comps = entities[id.id].components; comps != 0; comps &= comps - 1)
+        BitMath::unset_arr(component_tracker[BitMath::ctz(comps)].data(), id.id);
+    SERVER_ONLY(if (entities[id.id].has_component(kFlower)) free_flower_data.push_back(flower_index[id.id]);)
+    SERVER_ONLY(spatial_hash.remove(entities[id.id]);)
     hash_tracker[id.id]++;
+    _untrack_active(id.id);
 }
 
-void Simulation::tick() {
-    active_entities.clear();
-    for (EntityID::id_type i = 1; i < ENTITY_CAP; ++i) {
-        if (!BitMath::at_arr(entity_tracker.data(), i)) continue;
-        active_entities.push(entities[i].id.id);
-    }
-    on_tick();
+void Simulation::_track_active(EntityID::id_type id) {
+    active_index[id] = active_entities.size();
+    active_entities.push_back(id);
 }
 
-void Simulation::for_each_entity(std::function<void(Simulation *, Entity &)> cb) { \
-    for (EntityID::id_type i = 0; i < active_entities.size(); ++i) { \
-        if (!BitMath::at_arr(entity_tracker.data(), active_entities[i])) continue; \
-        Entity &ent = entities[active_entities[i]]; \
-        cb(this, ent); \
-    } \
+void Simulation::_move_active(uint32_t from, uint32_t to) {
+    if (from == to) return;
+    active_entities[to] = active_entities[from];
+    active_index[active_entities[to]] = to;
 }
 
-#define COMPONENT(name) \
-template<> \
-void Simulation::for_each<k##name>(std::function<void(Simulation *, Entity &)> cb) { \
-    for (EntityID::id_type i = 0; i < active_entities.size(); ++i) { \
-        if (!BitMath::at_arr(entity_tracker.data(), active_entities[i])) continue; \
-        Entity &ent = entities[active_entities[i]]; \
-        SERVER_ONLY(if (ent.pending_delete) continue;) \
-        if (ent.has_component(k##name)) cb(this, ent); \
-    } \
+//swap-remove that keeps active_entities partitioned as
+//[unvisited | visited | created after tick start]
+//so deleting mid-iteration neither skips nor revisits an entity
+//and never moves a new entity below the watermark
+void Simulation::_untrack_active(EntityID::id_type id) {
+    uint32_t pos = active_index[id];
+    if (pos < active_cursor) {
+        _move_active(active_cursor - 1, pos);
+        pos = --active_cursor;
+    }
+    if (pos < active_watermark) {
+        _move_active(active_watermark - 1, pos);
+        pos = --active_watermark;
+    }
+    _move_active(active_entities.size() - 1, pos);
+    active_entities.pop_back();
 }
-PERCOMPONENT
-#undef COMPONENT
\ No newline at end of file
+
+void Simulation::tick() {
+    active_watermark = active_entities.size();
+    tick_start_tracker = entity_tracker;
+    on_tick();
+}
\ No newline at end of file
@@ -3,32 +3,110 @@
 #include <Shared/Arena.hh>
 #include <Shared/Entity.hh>
 
+#include <Helpers/Math.hh>
+
 #ifdef SERVERSIDE
+#include <Server/CommandBuffer.hh>
+#include <Server/Scheduler.hh>
 #include <Server/SpatialHash.hh>
+#include <Server/System.hh>
+#include <Server/TargetIndex.hh>
 #endif
 
-#include <functional>
+#include <algorithm>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <span>
 #include <string>
+#include <vector>
 
-inline uint32_t const ENTITY_CAP = 8192;
+inline uint32_t const DEFAULT_ENTITY_CAP = 8192;
+//every slot id fits an EntityID::id_type, and set_capacity's round up to 64 fits a uint32_t
+inline uint32_t const MAX_ENTITY_CAP = std::min<uint64_t>(std::numeric_limits<EntityID::id_type>::max() + 1ull,
+    std::numeric_limits<uint32_t>::max()) / 64 * 64;
 
 class Simulation {
-    std::array<uint8_t, div_round_up(ENTITY_CAP, 8)> entity_tracker;
-    std::array<EntityID::hash_type, ENTITY_CAP> hash_tracker;
-    std::array<Entity, ENTITY_CAP> entities;
-    StaticArray<EntityID::id_type, ENTITY_CAP> active_entities;
+    //all per-slot storage below is sized by set_capacity
+    uint32_t entity_cap;
+    std::vector<uint64_t> entity_tracker;
+    //one bit per entity_tracker word, set while the word has a free slot, so alloc_ent
+    //skips full words 64 at a time
+    std::vector<uint64_t> free_word_tracker;
+    std::vector<EntityID::hash_type> hash_tracker;
+    //next slot alloc_ent starts searching from
+    EntityID::id_type alloc_cursor;
+    //one bitset of slots per component, plus the slots that were alive at the start of tick()
+    //component queries AND these together a word at a time
+    std::array<std::vector<uint64_t>, kComponentCount> component_tracker;
+    std::vector<uint64_t> tick_start_tracker;
+    std::unique_ptr<Entity[]> entities;
+    //dense list of live slots, kept up to date by alloc/delete
+    //[0, active_watermark) were alive at the start of tick(), anything after was created since
+    //while iterating, [0, active_cursor) are the entries that have not been visited yet
+    std::vector<EntityID::id_type> active_entities;
+    std::vector<EntityID::id_type> active_index;
+    uint32_t active_watermark;
+    uint32_t active_cursor;
+    void _track_active(EntityID::id_type);
+    void _update_free_word(uint32_t);
+    void _untrack_active(EntityID::id_type);
+    void _move_active(uint32_t, uint32_t);
+    template <uint32_t with, uint32_t without>
+    uint64_t _match_word(uint32_t) const;
+#ifdef SERVERSIDE
+    //one FlowerData per live kFlower entity, flower_index maps slot -> entry
+    //deque so references stay valid when a flower is allocated mid-loop
+    std::deque<FlowerData> flower_data;
+    std::vector<uint32_t> free_flower_data;
+    std::vector<uint32_t> flower_index;
+    //slots handed out to the worker pool by for_each_parallel
+    std::vector<EntityID::id_type> parallel_slots;
+    //(system in the stage, slot) pairs handed out by run_systems
+    std::vector<std::pair<uint32_t, EntityID::id_type>> stage_items;
+    //numbers the parallel passes of each system, see _frand_stream
+    uint32_t parallel_pass = 0;
+    //one per Scheduler thread, merged by flush_commands
+    std::vector<CommandBuffer> command_buffers;
+    std::vector<Command> merged_commands;
+    void _next_command_phase();
+    //frand stream for one entity in one parallel pass
+    static uint64_t _frand_stream(uint32_t, EntityID::id_type);
+    //_match_word with a mask only known at runtime
+    uint64_t _system_word(uint32_t, uint32_t) const;
+    void _run_serial(System const &);
+    void _run_stage(std::span<System const>);
+#endif
 public:
     SERVER_ONLY(std::array<uint32_t, PetalID::kNumPetals> petal_count_tracker;)
     SERVER_ONLY(std::array<uint32_t, MAP_DATA.size()> zone_mob_counts;)
     SERVER_ONLY(SpatialHash spatial_hash;)
+    SERVER_ONLY(TargetIndex target_index;)
     Arena arena_info;
     Simulation();
+    //resizes slot storage, rounded up to a multiple of 64. clears the simulation
+    void set_capacity(uint32_t);
+    uint32_t capacity() const;
     void reset();
     Entity &alloc_ent();
     void _delete_ent(EntityID const &); //DANGEROUS
     void force_alloc_ent(EntityID const &);
     void request_delete(EntityID const &);
+    void add_component(Entity &, uint32_t);
+    //indexes the components of an entity whose component set was written directly (ie. Entity::read)
+    void sync_components(Entity &);
     Entity &get_ent(EntityID const &);
+    SERVER_ONLY(FlowerData &get_flower_data(Entity const &);)
+#ifdef SERVERSIDE
+    //the calling thread's command buffer
+    CommandBuffer &commands();
+    //applies and clears every thread's commands. only call between systems
+    void flush_commands();
+    //runs the systems in order. consecutive ones that can run in parallel and do not conflict
+    //share a stage, one parallel pass over all of their entities, and the rest run serially
+    //like for_each. commands are flushed after every stage
+    void run_systems(std::span<System const>);
+#endif
     uint8_t ent_exists(EntityID const &) const;
     uint8_t ent_alive(EntityID const &) const;
     void tick();
@@ -36,7 +114,85 @@ public:
     void post_tick();
 
     //will only consider active entities from the start of the tick() call
-    void for_each_entity(std::function<void (Simulation *, Entity &)>);
-    template <uint8_t>
-    void for_each(std::function<void (Simulation *, Entity &)>);
-};
\ No newline at end of file
+    //callbacks are called as cb(Simulation *, Entity &)
+    template <typename Callback>
+    void for_each_entity(Callback const &);
+    //entities with every component in <with> and none in <without>
+    template <uint32_t with, uint32_t without = 0, typename Callback>
+    void for_each_matching(Callback const &);
+    template <uint8_t component, typename Callback>
+    void for_each(Callback const &);
+#ifdef SERVERSIDE
+    //same entities as for_each, split across the Scheduler worker pool
+    //cb may only write the entity it is called on, and must not alloc or delete
+    //other changes go through commands(). frand() draws from a stream of the entity's own,
+    //so the results do not depend on the thread count
+    template <uint8_t component, typename Callback>
+    void for_each_parallel(Callback const &);
+#endif
+};
+
+//iterates backwards so that swap-removals only ever pull in already visited entries
+template <typename Callback>
+void Simulation::for_each_entity(Callback const &cb) {
+    uint32_t const outer_cursor = active_cursor;
+    for (active_cursor = active_watermark; active_cursor > 0;) {
+        Entity &ent = entities[active_entities[--active_cursor]];
+        cb(this, ent);
+    }
+    active_cursor = outer_cursor;
+}
+
+template <uint32_t with, uint32_t without>
+uint64_t Simulation::_match_word(uint32_t word) const {
+    uint64_t bits = tick_start_tracker[word];
+    for (uint32_t c = 0; c < kComponentCount; ++c) {
+        if (BitMath::at(with, c)) bits &= component_tracker[c][word];
+        if (BitMath::at(without, c)) bits &= ~component_tracker[c][word];
+    }
+    return bits;
+}
+
+//the word is re-read after every callback, so entities deleted by
+//the callback are skipped even if they share the current word
+template <uint32_t with, uint32_t without, typename Callback>
+void Simulation::for_each_matching(Callback const &cb) {
+    for (uint32_t word = 0; word < tick_start_tracker.size(); ++word) {
+        uint64_t bits = _match_word<with, without>(word);
+        while (bits != 0) {
+            uint32_t bit = BitMath::ctz(bits);
+            Entity &ent = entities[word * 64 + bit];
+            SERVER_ONLY(if (!ent.pending_delete))
+                cb(this, ent);
+            bits = _match_word<with, without>(word) & ~((2ull << bit) - 1);
+        }
+    }
+}
+
+template <uint8_t component, typename Callback>
+void Simulation::for_each(Callback const &cb) {
+    for_each_matching<component_mask(component)>(cb);
+}
+
+#ifdef SERVERSIDE
+template <uint8_t component, typename Callback>
+void Simulation::for_each_parallel(Callback const &cb) {
+    parallel_slots.clear();
+    for (uint32_t word = 0; word < tick_start_tracker.size(); ++word) {
+        for (uint64_t bits = _match_word<component_mask(component), 0>(word); bits != 0; bits &= bits - 1) {
+            EntityID::id_type slot = word * 64 + BitMath::ctz(bits);
+            if (!entities[slot].pending_delete) parallel_slots.push_back(slot);
+        }
+    }
+    //commands issued in here sort apart from those issued before or after
+    _next_command_phase();
+    uint32_t const pass = ++parallel_pass;
+    Scheduler::parallel_for(parallel_slots.size(), [&](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; ++i) {
+            FrandStream stream(_frand_stream(pass, parallel_slots[i]));
+            cb(this, entities[parallel_slots[i]]);
+        }
+    });
+    _next_command_phase();
+}
+#endif
\ No newline at end of file
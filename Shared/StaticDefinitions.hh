@@ -150,7 +150,8 @@ namespace EntityFlags {
         kSpawnedFromZone,
         kNoDrops,
         kHasCulling,
-        kIsCulled
+        kIsCulled,
+        kFollowsParent
     };
 };
 